@@ -0,0 +1,120 @@
+/**
+ * @file bench_command_encoder.cpp
+ * @brief Micro-benchmark: prototype hex command strings vs. the binary CommandEncoder, with heap allocation counts
+ *
+ * Build with -DBUILD_BENCHMARKS=ON, then run ./bench_command_encoder
+ */
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <new>
+#include <sstream>
+#include <string>
+#include "command_encoder.h"
+
+using namespace rc_car;
+
+namespace {
+
+constexpr int ITERATIONS = 200000;
+
+std::atomic<long> allocations(0);
+
+// The prototype's command string (BLEHandler::generateCommand before the encoder)
+std::string intToHex(int value, int digits) {
+    std::stringstream ss;
+    ss << std::hex << std::setfill('0') << std::setw(digits) << value;
+    return ss.str();
+}
+
+std::string prototypeCommand(const std::string& identifier, const ControlVector& control) {
+    int steering = 0;
+    if (control.right_turn > 0) {
+        steering = control.right_turn;
+    } else if (control.left_turn > 0) {
+        steering = 255 - control.left_turn;
+    }
+    return identifier + intToHex(control.speed, 4) + intToHex(0, 4) + intToHex(steering, 4) +
+           (control.light_on ? "0200" : "0000") + "00";
+}
+
+ControlVector controlAt(int i) {
+    return ControlVector(i & 1, i % 101, (i % 3 == 0) ? i % 31 : 0, (i % 3 == 1) ? i % 29 : 0);
+}
+
+} // namespace
+
+// Count every heap allocation in the process
+void* operator new(std::size_t size) {
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size ? size : 1)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept {
+    std::free(p);
+}
+
+int main() {
+    const std::string identifier = "bf0a00082800";
+    CommandEncoder encoder;
+    encoder.setIdentifier(identifier);
+
+    // With the checksum off the packet must spell exactly the prototype string
+    encoder.setChecksum(false);
+    for (int i = 0; i < 1000; ++i) {
+        CommandEncoder::Packet packet;
+        encoder.encode(controlAt(i), packet);
+        char hex[2 * CommandEncoder::PACKET_SIZE];
+        CommandEncoder::toHex(packet, hex);
+        if (std::string(hex, sizeof(hex)) != prototypeCommand(identifier, controlAt(i))) {
+            std::cerr << "Error: packet differs from the prototype command for control " << i << std::endl;
+            return 1;
+        }
+    }
+    encoder.setChecksum(true);
+
+    volatile size_t sink = 0;
+
+    long before = allocations.load();
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < ITERATIONS; ++i) {
+        std::string command = prototypeCommand(identifier, controlAt(i));
+        sink = sink + command.size();
+    }
+    auto end = std::chrono::steady_clock::now();
+    double string_ns = std::chrono::duration<double, std::nano>(end - start).count() / ITERATIONS;
+    double string_allocs = static_cast<double>(allocations.load() - before) / ITERATIONS;
+
+    before = allocations.load();
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < ITERATIONS; ++i) {
+        CommandEncoder::Packet packet;
+        encoder.encode(controlAt(i), packet);
+        sink = sink + packet[CommandEncoder::PACKET_SIZE - 1];
+    }
+    end = std::chrono::steady_clock::now();
+    double packet_ns = std::chrono::duration<double, std::nano>(end - start).count() / ITERATIONS;
+    long packet_allocs = allocations.load() - before;
+
+    std::cout << std::fixed << std::setprecision(1);
+    std::cout << std::setw(10) << "encoder" << std::setw(14) << "ns/command" << std::setw(16) << "allocs/command" << std::endl;
+    std::cout << std::setw(10) << "hex" << std::setw(14) << string_ns << std::setw(16) << string_allocs << std::endl;
+    std::cout << std::setw(10) << "binary" << std::setw(14) << packet_ns << std::setw(16)
+              << static_cast<double>(packet_allocs) / ITERATIONS << std::endl;
+
+    if (packet_allocs != 0) {
+        std::cerr << "Error: binary encoder allocated " << packet_allocs << " times" << std::endl;
+        return 1;
+    }
+    return 0;
+}
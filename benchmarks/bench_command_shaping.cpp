@@ -0,0 +1,120 @@
+/**
+ * @file bench_command_shaping.cpp
+ * @brief Smoothness and tracking error of CommandShaper settings on a 30 Hz guidance signal
+ *
+ * Guidance samples a steering signal (a 1 Hz sweep with a step every two seconds,
+ * as when the car meets a corner) at 30 Hz with camera jitter; the shaper runs at
+ * 200 Hz. For each setting the table shows the largest step between consecutive
+ * packets, the RMS of the command's second difference (how jerky the actuation
+ * is) and the RMS error against the continuous signal. Simulated time, so it
+ * finishes at once.
+ *
+ * Build with -DBUILD_BENCHMARKS=ON, then run ./bench_command_shaping
+ */
+
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <vector>
+#include "command_shaper.h"
+
+using namespace rc_car;
+
+namespace {
+
+constexpr double SECONDS = 20.0;
+constexpr double GUIDANCE_HZ = 30.0;
+constexpr double SEND_HZ = 200.0;
+constexpr double CAMERA_JITTER_S = 0.004;
+constexpr double PI = 3.14159265358979323846;
+
+struct ShapingCase {
+    const char* name;
+    ShapingMode mode;
+    ChannelLimits steering;
+};
+
+double signal(double t) {
+    double sweep = 25.0 * std::sin(2.0 * PI * 1.0 * t);
+    double step = std::fmod(t, 4.0) < 2.0 ? 0.0 : 40.0;
+    return sweep + step - 20.0;
+}
+
+ControlVector steeringCommand(double value) {
+    int v = static_cast<int>(std::lround(value));
+    return ControlVector(1, 10, v > 0 ? v : 0, v < 0 ? -v : 0);
+}
+
+void runCase(const ShapingCase& shaping_case) {
+    ShapingParams params;
+    params.mode = shaping_case.mode;
+    params.steering = shaping_case.steering;
+    CommandShaper shaper;
+    shaper.setParams(params);
+
+    std::mt19937 rng(1);
+    std::uniform_real_distribution<double> jitter(0.0, CAMERA_JITTER_S);
+    const auto origin = std::chrono::steady_clock::time_point();
+    auto at = [origin](double t) {
+        return origin + std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(t));
+    };
+
+    double next_guidance = 0.0;
+    double prev = 0.0;
+    double prev2 = 0.0;
+    double max_step = 0.0;
+    double sum_sq_second = 0.0;
+    double sum_sq_error = 0.0;
+    long packets = 0;
+
+    for (long i = 0; i < static_cast<long>(SECONDS * SEND_HZ); ++i) {
+        double t = i / SEND_HZ;
+        while (next_guidance <= t) {
+            // The output describes the frame captured at the nominal time, arriving a little later
+            double frame_t = std::floor(next_guidance * GUIDANCE_HZ + 0.5) / GUIDANCE_HZ;
+            shaper.update(steeringCommand(signal(frame_t)), at(next_guidance));
+            next_guidance = frame_t + 1.0 / GUIDANCE_HZ + jitter(rng);
+        }
+        ControlVector out = shaper.shape(at(t));
+        double value = out.right_turn - out.left_turn;
+
+        if (packets >= 2) {
+            max_step = std::max(max_step, std::abs(value - prev));
+            double second = value - 2.0 * prev + prev2;
+            sum_sq_second += second * second;
+        }
+        double error = value - signal(t);
+        sum_sq_error += error * error;
+        prev2 = prev;
+        prev = value;
+        ++packets;
+    }
+
+    std::cout << std::setw(26) << shaping_case.name << std::setw(12) << max_step << std::setw(14)
+              << std::sqrt(sum_sq_second / packets) << std::setw(12) << std::sqrt(sum_sq_error / packets)
+              << std::endl;
+}
+
+} // namespace
+
+int main() {
+    const std::vector<ShapingCase> cases = {
+        {"off", ShapingMode::OFF, ChannelLimits()},
+        {"interpolate", ShapingMode::INTERPOLATE, ChannelLimits()},
+        {"extrapolate", ShapingMode::EXTRAPOLATE, ChannelLimits()},
+        {"off, rate 600", ShapingMode::OFF, ChannelLimits(600.0, 0.0)},
+        {"off, rate 600 jerk 20000", ShapingMode::OFF, ChannelLimits(600.0, 20000.0)},
+        {"interp, rate 600 jerk 2e4", ShapingMode::INTERPOLATE, ChannelLimits(600.0, 20000.0)},
+        {"extrap, rate 600 jerk 2e4", ShapingMode::EXTRAPOLATE, ChannelLimits(600.0, 20000.0)},
+    };
+
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << std::setw(26) << "shaping" << std::setw(12) << "max step" << std::setw(14) << "rms 2nd diff"
+              << std::setw(12) << "rms error" << std::endl;
+    for (const auto& shaping_case : cases) {
+        runCase(shaping_case);
+    }
+    return 0;
+}
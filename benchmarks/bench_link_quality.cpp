@@ -0,0 +1,161 @@
+/**
+ * @file bench_link_quality.cpp
+ * @brief Closed-loop benchmark: lane-keeping error of the steering controller as the BLE link degrades
+ *
+ * The guidance loop (30 Hz) steers a simulated car through BLEHandler, which streams
+ * commands at 200 Hz into a MockTransport. The car only ever acts on the command the
+ * mock link has delivered, so latency, jitter and loss show up in the tracking error.
+ * Runs in real time, about four seconds per link setting.
+ *
+ * Build with -DBUILD_BENCHMARKS=ON, then run ./bench_link_quality [pid|mpc]
+ */
+
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include "ble_handler.h"
+#include "command_encoder.h"
+#include "mock_transport.h"
+#include "steering_controller.h"
+
+using namespace rc_car;
+
+namespace {
+
+constexpr double SECONDS_PER_CASE = 4.0;
+constexpr double GUIDANCE_HZ = 30.0;
+constexpr double PHYSICS_HZ = 1000.0;
+constexpr double CAR_SPEED = 150.0;        // px/s
+constexpr double KICK_PERIOD_S = 1.0;      // Lateral disturbance every second, alternating sides
+constexpr double KICK_PX = 30.0;
+constexpr int STEERING_LIMIT = 30;
+constexpr double PI = 3.14159265358979323846;
+
+struct LinkCase {
+    const char* name;
+    double latency_ms;
+    double jitter_ms;
+    double loss;
+};
+
+struct CaseResult {
+    double rms_px;
+    double max_px;
+    MockLinkStats link;
+};
+
+CaseResult runCase(const LinkCase& link_case, SteeringMode mode) {
+    SteeringParams params;
+    SteeringController controller;
+    controller.setParams(params);
+    controller.setMode(mode);
+
+    MockLinkParams link;
+    link.latency_ms = link_case.latency_ms;
+    link.jitter_ms = link_case.jitter_ms;
+    link.loss = link_case.loss;
+    auto owned = std::make_unique<MockTransport>(link);
+    MockTransport* mock = owned.get();
+
+    BLEHandler ble("mock:", "6e400002-b5a3-f393-e0a9-e50e24dcca9e");
+    ble.setTransport(std::move(owned));
+    ble.connect();
+    ble.startSending();
+    CommandEncoder decoder;  // Same defaults as the handler's encoder
+
+    // Car state: lateral offset (px, positive = left of the lane centre) and heading (deg, positive = pointing left)
+    double offset = 0.0;
+    double heading = 0.0;
+    double steering = 0.0;   // Fraction of full lock the car is applying, positive = right
+
+    double sum_sq = 0.0;
+    double max_offset = 0.0;
+    long samples = 0;
+    int next_kick = 1;
+
+    const auto dt = std::chrono::duration<double>(1.0 / PHYSICS_HZ);
+    const int steps_per_guidance = static_cast<int>(PHYSICS_HZ / GUIDANCE_HZ);
+    const int total_steps = static_cast<int>(SECONDS_PER_CASE * PHYSICS_HZ);
+    auto start = std::chrono::steady_clock::now();
+
+    for (int step = 0; step < total_steps; ++step) {
+        auto now = start + std::chrono::duration_cast<std::chrono::steady_clock::duration>(dt * step);
+        std::this_thread::sleep_until(now);
+
+        if (step % steps_per_guidance == 0) {
+            // Guidance sees the car as a camera would: errors to steer out of, speed in px per cycle
+            double turn = controller.update(heading, offset, CAR_SPEED / GUIDANCE_HZ);
+            int value = static_cast<int>(std::lround(std::min(1.0, std::abs(turn)) * STEERING_LIMIT));
+            ControlVector control(1, 10, turn > 0 ? value : 0, turn < 0 ? value : 0);
+            ble.setControl(control);
+        }
+
+        // The car acts on whatever the link has delivered by now
+        CommandEncoder::Packet packet;
+        ControlVector received;
+        if (mock->commandAt(std::chrono::steady_clock::now(), packet) && decoder.decode(packet, received)) {
+            steering = static_cast<double>(received.right_turn - received.left_turn) / STEERING_LIMIT;
+        }
+
+        double wheel = steering * params.full_lock_angle * PI / 180.0;
+        heading -= CAR_SPEED / params.wheelbase * std::tan(wheel) / PHYSICS_HZ * 180.0 / PI;
+        offset += CAR_SPEED * std::sin(heading * PI / 180.0) / PHYSICS_HZ;
+
+        if (step >= next_kick * KICK_PERIOD_S * PHYSICS_HZ) {
+            offset += (next_kick % 2 ? KICK_PX : -KICK_PX);
+            ++next_kick;
+        }
+
+        sum_sq += offset * offset;
+        max_offset = std::max(max_offset, std::abs(offset));
+        ++samples;
+    }
+
+    ble.stopSending();
+    CaseResult result;
+    result.rms_px = std::sqrt(sum_sq / samples);
+    result.max_px = max_offset;
+    result.link = mock->getStats();
+    ble.disconnect();
+    return result;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    SteeringMode mode = SteeringMode::PID;
+    if (argc > 1 && std::string(argv[1]) == "mpc") {
+        mode = SteeringMode::MPC;
+    } else if (argc > 1 && std::string(argv[1]) != "pid") {
+        std::cerr << "Usage: " << argv[0] << " [pid|mpc]" << std::endl;
+        return 1;
+    }
+
+    const std::vector<LinkCase> cases = {
+        {"ideal", 0.0, 0.0, 0.0},
+        {"10ms", 10.0, 0.0, 0.0},
+        {"30ms+30j", 30.0, 30.0, 0.0},
+        {"loss 20%", 0.0, 0.0, 0.2},
+        {"loss 50%", 0.0, 0.0, 0.5},
+        {"100ms", 100.0, 0.0, 0.0},
+        {"150ms", 150.0, 0.0, 0.0},
+        {"250ms", 250.0, 0.0, 0.0},
+    };
+
+    std::cout << std::fixed << std::setprecision(1);
+    std::cout << std::setw(10) << "link" << std::setw(10) << "lost %" << std::setw(14) << "latency ms"
+              << std::setw(12) << "rms px" << std::setw(12) << "max px" << std::endl;
+    for (const auto& link_case : cases) {
+        CaseResult result = runCase(link_case, mode);
+        double lost = result.link.written > 0 ? 100.0 * result.link.lost / result.link.written : 0.0;
+        std::cout << std::setw(10) << link_case.name << std::setw(10) << lost << std::setw(14)
+                  << result.link.mean_latency_ms << std::setw(12) << result.rms_px << std::setw(12)
+                  << result.max_px << std::endl;
+    }
+    return 0;
+}
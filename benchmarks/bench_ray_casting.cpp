@@ -0,0 +1,102 @@
+/**
+ * @file bench_ray_casting.cpp
+ * @brief Micro-benchmark: serial mask ray casting vs. batch (SIMD) ray fans
+ *
+ * Build with -DBUILD_BENCHMARKS=ON, then run ./bench_ray_casting
+ */
+
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <vector>
+#include <functional>
+#include <opencv2/opencv.hpp>
+#include "ray_caster.h"
+#include "batch_ray_caster.h"
+
+using namespace rc_car;
+
+namespace {
+
+constexpr int MIN_DISTANCE = 20;
+constexpr int MAX_DISTANCE = 200;
+constexpr int ITERATIONS = 2000;
+
+// Synthetic oval-ish track: light ring between two dark regions
+cv::Mat makeTrackMask(int width, int height) {
+    cv::Mat gray(height, width, CV_8UC1, cv::Scalar(30));
+    cv::Point centre(width / 2, height / 2);
+    cv::circle(gray, centre, height / 2 - 20, cv::Scalar(200), -1);
+    cv::circle(gray, centre, height / 4, cv::Scalar(30), -1);
+
+    cv::Mat mask;
+    cv::threshold(gray, mask, 49, 255, cv::THRESH_BINARY_INV);
+    return mask;
+}
+
+std::vector<double> makeFan(int count, double heading) {
+    std::vector<double> angles(count);
+    for (int i = 0; i < count; ++i) {
+        angles[i] = heading - 90.0 + 180.0 * i / std::max(1, count - 1);
+    }
+    return angles;
+}
+
+double timeNs(const std::function<void()>& fn) {
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < ITERATIONS; ++i) {
+        fn();
+    }
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::nano>(end - start).count() / ITERATIONS;
+}
+
+} // namespace
+
+int main() {
+    cv::Mat mask = makeTrackMask(1920, 1080);
+    Position car(1920 / 2 + 1080 * 3 / 8, 1080 / 2);
+    double heading = 90.0;
+
+    PackedBoundaryMask packed;
+    double pack_ns = timeNs([&]() { packed.pack(mask); });
+
+    std::cout << "Batch backend: " << BatchRayCaster::backendName() << std::endl;
+    std::cout << "Mask pack (1920x1080): " << std::fixed << std::setprecision(1)
+              << pack_ns / 1000.0 << " us" << std::endl;
+    std::cout << std::setw(6) << "rays" << std::setw(14) << "serial ns"
+              << std::setw(14) << "scalar ns" << std::setw(14) << "batch ns" << std::endl;
+
+    volatile int sink = 0;
+    for (int count : {3, 32, 64, 128}) {
+        std::vector<double> angles = count == 3 ? std::vector<double>{heading - 60.0, heading, heading + 60.0}
+                                                : makeFan(count, heading);
+        std::vector<RayDirection> directions;
+        for (double angle : angles) {
+            directions.emplace_back(angle);
+        }
+        std::vector<int> scalar(count), batch(count);
+
+        double serial_ns = timeNs([&]() {
+            for (const auto& dir : directions) {
+                sink = sink + MaskRayCaster::castRay(mask, car, dir, MIN_DISTANCE, MAX_DISTANCE);
+            }
+        });
+        double scalar_ns = timeNs([&]() {
+            BatchRayCaster::castRaysScalar(packed, car, angles.data(), count, MIN_DISTANCE, MAX_DISTANCE, scalar.data());
+        });
+        double batch_ns = timeNs([&]() {
+            BatchRayCaster::castRays(packed, car, angles.data(), count, MIN_DISTANCE, MAX_DISTANCE, batch.data());
+        });
+
+        if (scalar != batch) {
+            std::cerr << "Error: batch and scalar results differ for " << count << " rays" << std::endl;
+            return 1;
+        }
+
+        std::cout << std::setw(6) << count << std::setw(14) << serial_ns
+                  << std::setw(14) << scalar_ns << std::setw(14) << batch_ns << std::endl;
+    }
+
+    return 0;
+}
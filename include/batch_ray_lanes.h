@@ -0,0 +1,42 @@
+#ifndef BATCH_RAY_LANES_H
+#define BATCH_RAY_LANES_H
+
+#include <cstdint>
+
+namespace rc_car {
+
+// Kernel interface of BatchRayCaster shared with src/batch_ray_caster_avx2.cpp, the
+// only file built for AVX2. Plain values only: inline functions compiled there could
+// be picked by the linker for code that must run on CPUs without AVX2.
+namespace batch_lanes {
+
+constexpr int FRACTION_BITS = 16;
+
+struct LaneDirection {
+    uint32_t step_x;   // |dx| * 2^16
+    uint32_t step_y;   // |dy| * 2^16
+    int32_t sign_x;    // +1 / -1
+    int32_t sign_y;
+};
+
+// One bit per pixel, as in PackedBoundaryMask
+struct MaskView {
+    const uint32_t* words;
+    int cols;
+    int rows;
+    int words_per_row;
+};
+
+// False when the build left the AVX2 kernel out (not x86, or no -mavx2)
+bool avx2KernelBuilt();
+
+// Casts the eight rays of `lanes` from (start_x, start_y); only call when
+// avx2KernelBuilt() and the CPU has AVX2
+void castBlockAVX2(const MaskView& mask, int start_x, int start_y, const LaneDirection* lanes,
+                   int min_distance, int max_distance, int* distances);
+
+} // namespace batch_lanes
+
+} // namespace rc_car
+
+#endif // BATCH_RAY_LANES_H
@@ -3,38 +3,178 @@
 
 #include <string>
 #include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
 #include <thread>
 #include <mutex>
 #include "types.h"
+#include "command_encoder.h"
+#include "command_shaper.h"
+#include "ble_transport.h"
+#include "mock_transport.h"
 
 namespace rc_car {
 
-// BLE Handler interface
-// Note: Actual BLE implementation depends on available library (BlueZ, simpleble-cpp, etc.)
-// This is a placeholder interface that can be implemented with the chosen BLE library
+// Write outcomes of the send path
+struct BLEStats {
+    long sent;     // Accepted by the link
+    long busy;     // Dropped because the transmit queue was full
+    long failed;   // Link errors
+    long offline;  // Not sent because the link was down
 
+    BLEStats() : sent(0), busy(0), failed(0), offline(0) {}
+};
+
+enum class LinkState {
+    DISCONNECTED,
+    CONNECTING,
+    CONNECTED,
+    GAVE_UP      // Reconnection attempts exhausted
+};
+
+// Link availability as seen by the connection manager
+struct ConnectionStats {
+    LinkState state;
+    long connects;            // Successful connects, the first one included
+    long failed_attempts;
+    long outages;             // Times an established link was lost
+    double current_outage_s;  // 0 while connected
+    double last_outage_s;     // Loss to reconnect, for the last completed outage
+    double max_outage_s;
+    double total_outage_s;
+
+    ConnectionStats()
+        : state(LinkState::DISCONNECTED), connects(0), failed_attempts(0), outages(0),
+          current_outage_s(0.0), last_outage_s(0.0), max_outage_s(0.0), total_outage_s(0.0) {}
+};
+
+enum class SendPolicy {
+    FIXED_RATE,  // Resend the current command every period
+    ON_CHANGE    // Send when the command changes, otherwise only as a keepalive
+};
+
+// Timing of the send loop
+struct SendTimingStats {
+    long cycles;
+    long overruns;            // Fixed rate: deadlines skipped because a cycle ran past the next one
+    double mean_interval_us;  // Fixed rate: between consecutive sends
+    double jitter_rms_us;     // Fixed rate: deviation of the send interval from the period
+    double jitter_max_us;
+    long change_sends;        // On change: sends carrying a new command
+    long keepalive_sends;     // On change: repeats after the keepalive interval
+    double mean_latency_us;   // On change: from the (first coalesced) change to its send
+    double max_latency_us;
+
+    SendTimingStats()
+        : cycles(0), overruns(0), mean_interval_us(0.0), jitter_rms_us(0.0), jitter_max_us(0.0),
+          change_sends(0), keepalive_sends(0), mean_latency_us(0.0), max_latency_us(0.0) {}
+};
+
+// Emergency stops: latency from request to the first stop packet handed to the link
+struct StopStats {
+    long requests;
+    long burst_packets;      // Stop packets sent in bursts
+    long blocked_commands;   // Control updates refused while the stop was latched
+    double mean_latency_us;
+    double max_latency_us;
+
+    StopStats() : requests(0), burst_packets(0), blocked_commands(0), mean_latency_us(0.0), max_latency_us(0.0) {}
+};
+
+// BLE Handler: streams the current control vector to the car, at a fixed rate or
+// whenever it changes (with a keepalive), over a BLETransport (AttTransport: Write Without Response on the command characteristic;
+// MockTransport for "mock:" addresses)
 class BLEHandler {
 private:
     std::string device_mac_;
     std::string device_characteristic_uuid_;
-    std::string device_identifier_;
+    CommandEncoder encoder_;  // Immutable while sending
+    std::unique_ptr<BLETransport> transport_;
+    bool transport_injected_;  // Set by setTransport(): kept across connects
+    MockLinkParams mock_link_;  // For "mock:" addresses
+    bool random_address_;
+    int connection_timeout_ms_;
+    
+    std::atomic<long> sent_;
+    std::atomic<long> busy_;
+    std::atomic<long> failed_;
+    std::atomic<long> offline_;
     
-    bool connected_;
+    std::atomic<bool> connected_;  // Session open: connect() succeeded or the connection manager runs
     std::atomic<bool> running_;
     std::thread send_thread_;
-    mutable std::mutex control_mutex_;  // Mutable to allow locking in const member functions
     
-    ControlVector current_control_;
-    int command_send_rate_hz_;  // Target rate (e.g., 200 Hz)
+    ControlSlot control_;  // Lock-free: producers never wait for the sender; latched during an emergency stop
+    std::atomic<uint64_t> control_updates_;  // Counts guidance outputs, repeats included, for the shaper
+    ControlSlot last_sent_;                // Last command handed to transmit()
+    CommandShaper shaper_;                 // Fixed rate only; owned by the send thread while sending
+    std::atomic<int64_t> change_time_ns_;  // steady_clock time of the first unsent change, 0 = none
+    std::mutex wake_mutex_;                // Only for sleeping on control_cv_
+    std::condition_variable control_cv_;   // Wakes the send loop for changes, stop requests and resends
+    std::atomic<bool> resend_request_;     // The link came back: the send loop repeats the current command
+    std::atomic<int> command_send_rate_hz_;  // Target rate (e.g., 200 Hz); changes apply while sending
+    SendPolicy send_policy_;
+    int keepalive_ms_;
+    double coalesce_ms_;  // Minimum spacing of change sends (the link's connection interval), 0 = off
+    
+    // Emergency stop: control_ is latched until clearEmergencyStop(); the request stamp makes the sender burst
+    std::atomic<int64_t> stop_request_ns_;  // steady_clock time of an unserved stop request, 0 = none
+    int stop_burst_;
+    double stop_burst_interval_ms_;
+    std::atomic<long> blocked_commands_;
+    
+    // Connection manager: keeps the link up from its own thread
+    std::thread manager_thread_;
+    std::atomic<bool> managing_;
+    mutable std::mutex manager_mutex_;     // Guards the link statistics below; manager_cv_ sleeps on it
+    std::condition_variable manager_cv_;
+    int reconnect_attempts_;               // Consecutive failures before giving up, 0 = never
+    int backoff_initial_ms_;
+    int backoff_max_ms_;
+    LinkState link_state_;
+    long link_connects_;
+    long link_failed_attempts_;
+    long link_outages_;
+    bool in_outage_;
+    std::chrono::steady_clock::time_point outage_start_;
+    double last_outage_s_;
+    double max_outage_s_;
+    double total_outage_s_;
+    
+    static constexpr int LINK_POLL_MS = 50;  // Link check while connected (failed writes also wake the manager)
+    
+    // Send timing, written by the send loop
+    mutable std::mutex timing_mutex_;
+    long timing_cycles_;
+    long timing_overruns_;
+    long timing_intervals_;
+    double interval_sum_us_;
+    double deviation_sq_sum_us_;
+    double deviation_max_us_;
+    long change_sends_;
+    long keepalive_sends_;
+    double latency_sum_us_;
+    double latency_max_us_;
+    long stop_requests_;
+    long stop_burst_packets_;
+    double stop_latency_sum_us_;
+    double stop_latency_max_us_;
     
     void sendLoop();
-    std::string generateCommand(const ControlVector& control) const;
-    std::string intToHex(int value, int digits = 4) const;
+    void sendFixedRate();
+    void sendOnChange();
+    bool transmit(const ControlVector& control, bool& failing);
+    void noteChange();
+    bool serviceStop(bool& failing);   // Sends a pending stop burst; true if there was one
+    void noteWrite(SlotWrite result);  // Change notification or blocked-command count
     
-    // BLE connection methods (to be implemented based on chosen library)
-    bool connectToDevice();
+    bool createTransport();
+    void connectionLoop();
+    void requestResend();
+    void resendLatest(bool& failing);
     void disconnectFromDevice();
-    bool sendCommand(const std::string& command);
+    bool sendCommand(const CommandEncoder::Packet& packet);
     
 public:
     BLEHandler();
@@ -42,28 +182,84 @@ public:
     ~BLEHandler();
     
     bool initialize(const std::string& mac_address, const std::string& characteristic_uuid);
-    bool connect();
+    bool connect();      // Blocking, single attempt
     void disconnect();
     
+    // Connect and reconnect in the background with exponential backoff; never blocks the caller.
+    // Sending can start right away: commands are counted as offline until the link is up.
+    bool startConnectionManager();
+    void stopConnectionManager();
+    void setReconnect(int attempts, int backoff_initial_ms, int backoff_max_ms) {
+        reconnect_attempts_ = attempts;
+        backoff_initial_ms_ = backoff_initial_ms;
+        backoff_max_ms_ = backoff_max_ms;
+    }
+    ConnectionStats getConnectionStats() const;
+    
     void setControl(const ControlVector& control);
     ControlVector getControl() const;
     
     void startSending();
     void stopSending();
     
-    bool isConnected() const { return connected_; }
+    bool isConnected() const { return connected_ && transport_ && transport_->isConnected(); }
+    LinkState getLinkState() const { return getConnectionStats().state; }
     
     void setCommandRate(int hz) { command_send_rate_hz_ = hz; }
+    
+    // Packet fields as hex strings from the config (set before sending starts)
+    bool setDeviceIdentifier(const std::string& hex) { return encoder_.setIdentifier(hex); }
+    bool setLightValues(const std::string& on_hex, const std::string& off_hex) {
+        return encoder_.setLightValues(on_hex, off_hex);
+    }
+    void setChecksum(bool enabled) { encoder_.setChecksum(enabled); }
+    
+    // Link settings (before connect)
+    void setRandomAddress(bool random) { random_address_ = random; }
+    void setConnectionTimeout(int ms) { connection_timeout_ms_ = ms; }
+    void setMockLink(const MockLinkParams& params) { mock_link_ = params; }
+    
+    // Use this transport instead of one chosen by the address (before connect);
+    // a test harness keeps a raw pointer to read what the car received
+    void setTransport(std::unique_ptr<BLETransport> transport);
+    BLETransport* getTransport() const { return transport_.get(); }
+    
+    BLEStats getStats() const;
+    SendTimingStats getTimingStats() const;
     int getCommandRate() const { return command_send_rate_hz_; }
     
+    // Transmission policy (before sending starts)
+    void setSendPolicy(SendPolicy policy, int keepalive_ms, double coalesce_ms) {
+        send_policy_ = policy;
+        keepalive_ms_ = keepalive_ms;
+        coalesce_ms_ = coalesce_ms;
+    }
+    SendPolicy getSendPolicy() const { return send_policy_; }
+    
     // Light control helpers
     void setLight(bool on);
     void setSpeed(int speed);
     void setReverseSpeed(int speed);
     void setSteering(int left_value, int right_value);
     
-    // Emergency stop
+    // Command shaping between guidance updates (before sending starts; fixed-rate policy only)
+    void setShaping(const ShapingParams& params) { shaper_.setParams(params); }
+    const ShapingParams& getShaping() const { return shaper_.getParams(); }
+    bool isShaping() const { return shaper_.isEnabled(); }
+    // Largest speed either direction accepts: the shaper reads speed bytes as signed
+    int maxSpeed() const { return shaper_.isEnabled() ? CommandShaper::MAX_FORWARD_SPEED : 254; }
+    
+    // Emergency stop: the send loop is woken to send `burst` stop packets ahead of its
+    // schedule, and only stop commands go out until the latch is cleared. Never sends
+    // from the caller; without a send loop the burst goes out when sending starts.
     void emergencyStop();
+    void clearEmergencyStop();
+    bool isEmergencyStopped() const { return control_.isLatched(); }
+    void setStopBurst(int packets, double interval_ms) {
+        stop_burst_ = packets;
+        stop_burst_interval_ms_ = interval_ms;
+    }
+    StopStats getStopStats() const;
 };
 
 } // namespace rc_car
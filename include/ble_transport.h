@@ -0,0 +1,127 @@
+#ifndef BLE_TRANSPORT_H
+#define BLE_TRANSPORT_H
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace rc_car {
+
+// ATT protocol constants (Bluetooth Core Spec, Vol 3, Part F)
+namespace att {
+
+constexpr uint16_t CID = 0x0004;           // Fixed L2CAP channel of ATT on LE links
+constexpr size_t DEFAULT_MTU = 23;         // Without an MTU exchange
+constexpr size_t MAX_PDU = 512 + 3;
+
+constexpr uint8_t ERROR_RSP = 0x01;
+constexpr uint8_t MTU_REQ = 0x02;
+constexpr uint8_t MTU_RSP = 0x03;
+constexpr uint8_t READ_BY_TYPE_REQ = 0x08;
+constexpr uint8_t READ_BY_TYPE_RSP = 0x09;
+constexpr uint8_t WRITE_CMD = 0x52;        // Write Without Response
+
+constexpr uint8_t ERR_ATTRIBUTE_NOT_FOUND = 0x0a;
+constexpr uint8_t ERR_REQUEST_NOT_SUPPORTED = 0x06;
+
+constexpr uint16_t CHARACTERISTIC_UUID = 0x2803;  // Characteristic declaration
+constexpr uint8_t PROP_WRITE_NO_RESPONSE = 0x04;
+
+using Uuid = std::array<uint8_t, 16>;      // 128-bit UUID, little-endian as on the wire
+
+// "6e400002-b5a3-f393-e0a9-e50e24dcca9e" -> wire order; false on malformed input
+bool parseUuid(const std::string& text, Uuid& uuid);
+
+// 16-bit UUID in the Bluetooth base UUID
+Uuid shortUuid(uint16_t uuid);
+
+inline void putLe16(uint8_t* out, uint16_t value) {
+    out[0] = static_cast<uint8_t>(value & 0xff);
+    out[1] = static_cast<uint8_t>(value >> 8);
+}
+
+inline uint16_t getLe16(const uint8_t* in) {
+    return static_cast<uint16_t>(in[0] | (in[1] << 8));
+}
+
+} // namespace att
+
+enum class WriteResult {
+    OK,
+    BUSY,    // Transmit queue full (no controller credits): nothing was sent, try the next command
+    FAILED   // Link is gone
+};
+
+// Link to the car that carries fixed-size command packets
+class BLETransport {
+public:
+    virtual ~BLETransport() = default;
+
+    virtual bool connect() = 0;
+    virtual void disconnect() = 0;
+    virtual bool isConnected() const = 0;
+
+    // Never blocks
+    virtual WriteResult write(const uint8_t* data, size_t size) = 0;
+
+    // From another thread: a connect() in progress, and any started before
+    // resumeConnect(), gives up at once instead of running to its timeout
+    virtual void abortConnect() {}
+    virtual void resumeConnect() {}
+};
+
+// GATT client over a raw ATT channel. On Linux the channel is an L2CAP LE socket
+// on the fixed ATT CID, so no D-Bus round trip or bluetoothd involvement sits in
+// the send path; "unix:<path>" addresses use a local SOCK_SEQPACKET socket
+// instead (the framing is identical), which is how tools/fake_peripheral stands
+// in for the car. After connecting, the value handle of the characteristic is
+// found with Read By Type over the characteristic declarations, and every
+// command is a single Write Without Response PDU.
+//
+// The socket is non-blocking and its send buffer is kept to a few PDUs: when the
+// controller runs out of ACL credits, write() reports BUSY instead of queueing,
+// so the car never receives a backlog of stale commands.
+//
+// connect() may run on another thread while write() is being called (reconnects):
+// until discovery has finished, write() sees no socket and reports FAILED. Only
+// one thread writes; a socket closed by a failed write is never reused under it.
+// Every wait of an attempt also polls a wake pipe, so abortConnect() ends it early.
+class AttTransport : public BLETransport {
+private:
+    std::string address_;          // "aa:bb:cc:dd:ee:ff" or "unix:/path"
+    att::Uuid characteristic_;
+    bool random_address_;          // LE address type of the car
+    int timeout_ms_;               // Connect and discovery
+    std::atomic<int> fd_;          // Published only once discovery is done; used by the single writer
+    int pending_fd_;               // Socket while connecting (connecting thread only)
+    std::atomic<uint16_t> value_handle_;
+    std::atomic<bool> aborted_;
+    int wake_pipe_[2];             // Readable while aborted
+
+    static constexpr int SEND_BUFFER_PDUS = 4;
+
+    bool openSocket();             // Into pending_fd_
+    int pollPending(short events, int timeout_ms);  // As poll(), 0 if aborted
+    bool waitWritable();
+    bool request(const uint8_t* pdu, size_t size, uint8_t* response, size_t& response_size);
+    bool discoverHandle();
+
+public:
+    AttTransport(const std::string& address, const att::Uuid& characteristic, bool random_address, int timeout_ms);
+    ~AttTransport() override;
+
+    bool connect() override;
+    void disconnect() override;
+    bool isConnected() const override { return fd_ >= 0; }
+    WriteResult write(const uint8_t* data, size_t size) override;
+    void abortConnect() override;
+    void resumeConnect() override;
+
+    uint16_t valueHandle() const { return value_handle_; }
+};
+
+} // namespace rc_car
+
+#endif // BLE_TRANSPORT_H
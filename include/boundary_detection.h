@@ -3,10 +3,32 @@
 
 #include <opencv2/opencv.hpp>
 #include <vector>
+#include <algorithm>
+#include <string>
 #include "types.h"
+#include "distance_field.h"
+#include "ray_caster.h"
+#include "batch_ray_caster.h"
+#include "track_centreline.h"
+#include "racing_line.h"
+#include "policy_table.h"
+#include "track_cache.h"
+#include "tiled_boundary_mask.h"
+#include "mask_pyramid.h"
+#include "ground_projection.h"
+#include "steering_controller.h"
 
 namespace rc_car {
 
+enum class GuidanceMode {
+    RAY_MARCH,       // March every ray over a boundary mask of the current frame
+    DISTANCE_FIELD,  // Sphere-trace rays over a distance field of the (static) track
+    POLAR_HISTOGRAM, // Dense ray fan -> smoothed clearance histogram -> best free sector (VFH)
+    PURE_PURSUIT,    // Follow the pre-extracted track centreline with a lookahead point
+    RACING_LINE,     // Follow a precomputed racing line; target speed comes from its speed profile
+    POLICY_TABLE     // Ray distances looked up from a precomputed (x, y, heading) table of the track
+};
+
 class BoundaryDetection {
 private:
     int black_threshold_;
@@ -15,13 +37,114 @@ private:
     std::vector<double> ray_angles_;  // Relative angles in degrees
     
     cv::Mat gray_frame_;
-    cv::Mat binary_frame_;
+    cv::Mat binary_frame_;  // CV_8UC1 boundary mask (255 = boundary) of the window around the car
+    cv::Point mask_origin_; // Frame position of the mask's top-left pixel
     
     std::vector<Ray> rays_;
     
+    // Dense ray fans: cast all rays at once over a bit-packed mask
+    bool batch_rays_;
+    PackedBoundaryMask packed_mask_;
+    std::vector<double> fan_angles_;
+    std::vector<int> fan_distances_;
+    
+    GuidanceMode mode_;
+    DistanceField distance_field_;
+    int field_refresh_frames_;   // Rebuild the distance field every N frames (0 = only on demand)
+    int frames_since_refresh_;
+    bool field_refresh_requested_;
+    
+    // Polar clearance histogram
+    int histogram_rays_;
+    double histogram_fov_;       // Degrees, centred on the heading
+    int histogram_smoothing_;    // Half-width (bins) of the smoothing window
+    std::vector<double> histogram_angles_;  // Relative angles of the fan
+    std::vector<float> histogram_;          // Smoothed clearance per bin (pixels)
+    
+    // Pure pursuit on the track centreline
+    TrackCentreline centreline_;
+    cv::Mat track_mask_;          // Boundary mask from a track image (empty = use the first frame)
+    int lookahead_;               // Pixels ahead along the centreline
+    double wheelbase_;            // Pixels
+    float waypoint_spacing_;
+    int travel_direction_;        // +1 / -1 along the centreline
+    Position lookahead_point_;
+    int pursuit_index_;           // Nearest line point from the last pursuit step
+    int line_retry_frames_;       // Frames left before a failed line preparation is tried again
+    
+    // Racing line with per-point speed profile (loaded from disk or optimised once)
+    RacingLine racing_line_;
+    RacingLineParams racing_params_;
+    
+    // Precomputed ray distances per pose
+    PolicyTable policy_table_;
+    int policy_cell_size_;        // Pixels per grid cell
+    int policy_headings_;         // Heading bins over 360 degrees
+    
+    // Derived artefacts of the track image are cached on disk
+    TrackCache cache_;
+    bool centreline_from_track_;  // centreline_ was derived from track_mask_ (and may be cached)
+    
+    // Incremental mask: only changed tiles are re-thresholded (and re-derived in the distance field)
+    bool incremental_mask_;
+    TiledBoundaryMask tiled_mask_;
+    cv::Rect car_bbox_;           // Tracker bbox of the car, excluded from mask updates
+    
+    // Empty-space skipping: long rays jump over free blocks of a max-mip pyramid of the mask
+    bool hierarchical_rays_;
+    MaskPyramid mask_pyramid_;
+    
+    // Coherent rays: each ray starts from its last hit on the pyramid (exact, see castRayFrom)
+    bool coherent_rays_;
+    bool verify_rays_;            // Also cast every ray with MaskRayCaster and count mismatches
+    Position prev_ray_pos_;
+    std::vector<double> prev_ray_angles_;   // Absolute angles of last frame's rays
+    std::vector<int> prev_ray_distances_;   // Empty = no coherent frame to start from
+    CoherentRayStats ray_stats_;
+    
+    // Bird's-eye guidance: mask-based rays run on the calibrated ground grid (undistorted, metric)
+    GroundProjection ground_;
+    cv::Mat ground_frame_;        // Warped window around the car
+    bool ground_view_;            // The current mask is a ground-grid window
+    
+    // Steering: bang-bang (prototype) or continuous PID / MPC on the ray and histogram errors
+    SteeringController steering_;
+    int steering_limit_;          // Largest left/right turn value sent to the car
+    bool evasive_target_;         // The last continuous cycle steered for the most open ray
+    
+    static constexpr int RAY_START_OFFSET = 20;  // Skip the car itself
+    static constexpr double FULL_LOCK_ANGLE = 60.0;  // Sector offset (deg) that maps to full steering
+    static constexpr double MIN_SPEED_FACTOR = 0.3;  // Histogram mode never drops below 30% of base speed
+    static constexpr int INCREMENTAL_FIELD_CAP = 32; // Distance field cap (px) that keeps tile updates local
+    static constexpr int LINE_RETRY_FRAMES = 30;     // A failed centreline/racing line is retried about once a second
+    static constexpr double ANGLE_TOLERANCE = 1e-6;  // Ray angles (deg) this close match; relative above 1 deg
+    static constexpr int COHERENT_MAX_SHIFT = 8;     // Car movement (px per axis) that still reuses last hits
+    static constexpr double COHERENT_MAX_TURN = 5.0; // Ray rotation (deg) that still reuses last hits
+    
+    const std::vector<double>& activeRayAngles() const;
     void updateRays(const Position& car_pos, double car_heading);
-    int castRay(const Position& start, double angle, const cv::Mat& track_image);
-    bool isBoundaryPixel(const cv::Vec3b& pixel) const;
+    int marchRay(const Position& local, const RayDirection& dir) const;
+    int castCoherent(size_t index, const Position& local, const RayDirection& dir, double angle, bool stable);
+    void rebuildHistogramFan();
+    bool histogramWraps() const { return histogram_fov_ >= 360.0; }
+    
+    // Steering policies
+    ControlVector rayGuidance(double car_heading, double car_speed, int base_speed);
+    ControlVector histogramGuidance(double car_speed, int base_speed);
+    ControlVector pursuitGuidance(const TrackCentreline& line, const Position& car_pos,
+                                  const MovementVector& movement, int base_speed);
+    double crossTrackError() const;
+    void setSteering(ControlVector& control, double turn) const;
+    
+    // Threshold the frame once into a single-channel boundary mask
+    void buildBoundaryMask(const cv::Mat& frame, cv::Mat& mask);
+    void refreshDistanceField(const cv::Mat& frame, const Position& car_pos);
+    void updateMaskTiles(const cv::Mat& frame, const Position& car_pos);
+    std::string centrelineCacheParams() const;
+    void buildGroundMask(const cv::Mat& frame, const Position& ground_pos);
+    const cv::Mat& rayMask() const {
+        return (incremental_mask_ && !ground_view_) ? tiled_mask_.mask() : binary_frame_;
+    }
     
 public:
     BoundaryDetection();
@@ -32,6 +155,81 @@ public:
     void setEvasiveThreshold(int threshold) { evasive_threshold_ = threshold; }
     void setRayAngles(const std::vector<double>& angles) { ray_angles_ = angles; }
     
+    void setBatchRays(bool enabled) { batch_rays_ = enabled; }
+    // Below 360° an even ray count is rounded up, so one bin points straight ahead
+    void setHistogramFan(int rays, double fov_deg);
+    void setHistogramSmoothing(int half_width) { histogram_smoothing_ = std::max(0, half_width); }
+    
+    // Pure pursuit: centreline source and geometry
+    bool loadTrackImage(const std::string& path);
+    void setLookahead(int pixels) { lookahead_ = std::max(1, pixels); }
+    void setWheelbase(double pixels) { wheelbase_ = pixels; }
+    void setWaypointSpacing(float pixels) { waypoint_spacing_ = std::max(1.0f, pixels); }
+    const TrackCentreline& getCentreline() const { return centreline_; }
+    
+    // Extract the centreline from a track image or frame (track image mask takes precedence)
+    bool extractCentreline(const cv::Mat& frame, const Position& seed);
+    
+    // Racing line: load a table produced offline, or optimise one from the extracted centreline
+    bool loadRacingLine(const std::string& path);
+    bool buildRacingLine();
+    void setRacingLineParams(const RacingLineParams& params) { racing_params_ = params; }
+    const RacingLine& getRacingLine() const { return racing_line_; }
+    
+    // Policy table: load a memory-mapped table, or cast it from the track image / frame on all cores
+    // (from a frame, the car at car_pos is cleared from the mask first)
+    bool loadPolicyTable(const std::string& path);
+    bool buildPolicyTable(const cv::Mat& frame, const Position& car_pos);
+    void setPolicyGrid(int cell_size, int headings);
+    const PolicyTable& getPolicyTable() const { return policy_table_; }
+    
+    // Incremental boundary mask over tiles; the car's bbox (from the tracker) is never re-thresholded
+    void setIncrementalMask(bool enabled) { incremental_mask_ = enabled; tiled_mask_.invalidate(); }
+    void setMaskTiling(int tile_size, int diff_threshold);
+    void setCarBBox(const cv::Rect& bbox) { car_bbox_ = bbox; }
+    
+    // Hierarchical rays (RAY_MARCH over the mask, not batched): same distances, cost ~log(ray length)
+    void setHierarchicalRays(bool enabled) { hierarchical_rays_ = enabled; mask_pyramid_.clear(); }
+    
+    // Coherent rays (RAY_MARCH over the mask, not batched): same distances, each ray starts
+    // from last frame's hit; verification also casts every ray plainly and counts mismatches
+    void setCoherentRays(bool enabled, bool verify);
+    bool isCoherentRays() const { return coherent_rays_; }
+    const CoherentRayStats& getCoherentRayStats() const { return ray_stats_; }
+    
+    // Ground projection table from tools/ground_calibrate. When it matches the frame size, the
+    // ray_march and polar_histogram modes cast over the bird's-eye view, so ray_max_length and
+    // evasive_threshold are in ground pixels (unitsPerPixel() mm each); the incremental mask is not used.
+    bool loadGroundProjection(const std::string& path);
+    const GroundProjection& getGroundProjection() const { return ground_; }
+    
+    // Steering controller for the ray_march, distance_field, policy_table and polar_histogram modes
+    // (pursuit modes keep pure pursuit); every mode is clipped at the steering limit
+    void setSteeringLimit(int limit) { steering_limit_ = std::max(0, std::min(255, limit)); }
+    void setSteeringMode(SteeringMode mode) { steering_.setMode(mode); }
+    void setSteeringParams(const SteeringParams& params) { steering_.setParams(params); }
+    SteeringMode getSteeringMode() const { return steering_.getMode(); }
+    const SteeringStats& getSteeringStats() const { return steering_.getStats(); }
+    
+    // Directory for cached track artefacts (empty = disabled); only used with a track image
+    void setCacheDirectory(const std::string& directory) { cache_.setDirectory(directory); }
+    
+    // Smoothed polar clearance histogram from the last POLAR_HISTOGRAM frame
+    const std::vector<float>& getHistogram() const { return histogram_; }
+    bool isBatchRays() const { return batch_rays_; }
+    
+    void setMode(GuidanceMode mode) { mode_ = mode; }
+    GuidanceMode getMode() const { return mode_; }
+    void setFieldRefreshFrames(int frames) { field_refresh_frames_ = frames; }
+    
+    // Rebuild the distance field from the next processed frame
+    void requestFieldRefresh() { field_refresh_requested_ = true; }
+    
+    // Distance (pixels) from a position to the nearest track boundary or frame edge.
+    // Only available in DISTANCE_FIELD mode once the field has been built; returns -1 otherwise.
+    // With the incremental mask the field saturates at INCREMENTAL_FIELD_CAP.
+    float distanceToNearestWall(const Position& pos) const;
+    
     // Main processing function
     ControlVector process(const cv::Mat& frame, const Position& car_position, 
                          const MovementVector& movement, int base_speed = 10);
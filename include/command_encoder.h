@@ -0,0 +1,165 @@
+#ifndef COMMAND_ENCODER_H
+#define COMMAND_ENCODER_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include "types.h"
+
+namespace rc_car {
+
+namespace command_tables {
+
+// Lower-case hex digit pairs for every byte value ("00".."ff")
+constexpr std::array<char, 512> makeHexPairs() {
+    std::array<char, 512> pairs{};
+    const char digits[] = "0123456789abcdef";
+    for (int b = 0; b < 256; ++b) {
+        pairs[2 * b] = digits[b >> 4];
+        pairs[2 * b + 1] = digits[b & 0x0f];
+    }
+    return pairs;
+}
+
+// Nibble value of an ASCII hex digit, -1 for anything else
+constexpr std::array<int8_t, 256> makeNibbles() {
+    std::array<int8_t, 256> nibbles{};
+    for (int c = 0; c < 256; ++c) {
+        nibbles[c] = (c >= '0' && c <= '9') ? static_cast<int8_t>(c - '0')
+                   : (c >= 'a' && c <= 'f') ? static_cast<int8_t>(c - 'a' + 10)
+                   : (c >= 'A' && c <= 'F') ? static_cast<int8_t>(c - 'A' + 10)
+                   : static_cast<int8_t>(-1);
+    }
+    return nibbles;
+}
+
+constexpr std::array<char, 512> HEX_PAIRS = makeHexPairs();
+constexpr std::array<int8_t, 256> NIBBLES = makeNibbles();
+
+static_assert(HEX_PAIRS[2 * 0xbf] == 'b' && HEX_PAIRS[2 * 0xbf + 1] == 'f', "Hex table");
+static_assert(NIBBLES['F'] == 15 && NIBBLES['7'] == 7 && NIBBLES['g'] == -1, "Nibble table");
+
+} // namespace command_tables
+
+// Binary form of the prototype's hex command string:
+//   identifier (6) | speed (2) | drift (2) | steering (2) | light (2) | checksum (1)
+// 16-bit fields are big-endian, exactly the bytes the hex string spelled out. The
+// checksum is the 8-bit sum of the preceding bytes; it is off by default, sending
+// 0x00 as the prototype did, since only firmware that checks it accepts it. Encoding
+// writes into a caller-owned fixed-size array and never allocates, so the 200 Hz
+// send loop produces no heap traffic.
+class CommandEncoder {
+public:
+    static constexpr size_t IDENTIFIER_SIZE = 6;
+    static constexpr size_t PACKET_SIZE = IDENTIFIER_SIZE + 4 * 2 + 1;
+    using Packet = std::array<uint8_t, PACKET_SIZE>;
+
+private:
+    std::array<uint8_t, IDENTIFIER_SIZE> identifier_;
+    uint16_t light_on_;
+    uint16_t light_off_;
+    bool checksum_;
+
+    static void putWord(uint8_t* out, uint16_t value) {
+        out[0] = static_cast<uint8_t>(value >> 8);
+        out[1] = static_cast<uint8_t>(value & 0xff);
+    }
+
+public:
+    CommandEncoder()
+        : identifier_{{0xbf, 0x0a, 0x00, 0x08, 0x28, 0x00}}, light_on_(0x0200), light_off_(0x0000), checksum_(false) {}
+
+    // Parse a hex string of exactly `size` bytes; out is untouched on failure
+    static bool parseHex(const std::string& hex, uint8_t* out, size_t size) {
+        if (hex.size() != 2 * size) {
+            return false;
+        }
+        for (size_t i = 0; i < hex.size(); ++i) {
+            if (command_tables::NIBBLES[static_cast<uint8_t>(hex[i])] < 0) {
+                return false;
+            }
+        }
+        for (size_t i = 0; i < size; ++i) {
+            out[i] = static_cast<uint8_t>((command_tables::NIBBLES[static_cast<uint8_t>(hex[2 * i])] << 4) |
+                                          command_tables::NIBBLES[static_cast<uint8_t>(hex[2 * i + 1])]);
+        }
+        return true;
+    }
+
+    // Configuration (hex strings as in the config file); false leaves the old value
+    bool setIdentifier(const std::string& hex) { return parseHex(hex, identifier_.data(), IDENTIFIER_SIZE); }
+    bool setLightValues(const std::string& on_hex, const std::string& off_hex) {
+        uint8_t on[2];
+        uint8_t off[2];
+        if (!parseHex(on_hex, on, 2) || !parseHex(off_hex, off, 2)) {
+            return false;
+        }
+        light_on_ = static_cast<uint16_t>((on[0] << 8) | on[1]);
+        light_off_ = static_cast<uint16_t>((off[0] << 8) | off[1]);
+        return true;
+    }
+    void setChecksum(bool enabled) { checksum_ = enabled; }
+
+    void encode(const ControlVector& control, Packet& packet) const {
+        // Steering byte as in the prototype: right turn as is, left turn mirrored from 255
+        int steering = 0;
+        if (control.right_turn > 0) {
+            steering = control.right_turn;
+        } else if (control.left_turn > 0) {
+            steering = 255 - control.left_turn;
+        }
+
+        uint8_t* out = packet.data();
+        for (size_t i = 0; i < IDENTIFIER_SIZE; ++i) {
+            out[i] = identifier_[i];
+        }
+        putWord(out + IDENTIFIER_SIZE, static_cast<uint16_t>(control.speed));
+        putWord(out + IDENTIFIER_SIZE + 2, 0);  // Drift
+        putWord(out + IDENTIFIER_SIZE + 4, static_cast<uint16_t>(steering));
+        putWord(out + IDENTIFIER_SIZE + 6, control.light_on ? light_on_ : light_off_);
+
+        uint8_t sum = 0;
+        if (checksum_) {
+            for (size_t i = 0; i < PACKET_SIZE - 1; ++i) {
+                sum = static_cast<uint8_t>(sum + out[i]);
+            }
+        }
+        out[PACKET_SIZE - 1] = sum;
+    }
+
+    // Inverse of encode() as the car reads it: steering bytes above 127 are left turns.
+    // False if the identifier or (when enabled) the checksum does not match.
+    bool decode(const Packet& packet, ControlVector& control) const {
+        const uint8_t* in = packet.data();
+        uint8_t sum = 0;
+        for (size_t i = 0; i < PACKET_SIZE - 1; ++i) {
+            sum = static_cast<uint8_t>(sum + in[i]);
+            if (i < IDENTIFIER_SIZE && in[i] != identifier_[i]) {
+                return false;
+            }
+        }
+        if (checksum_ && in[PACKET_SIZE - 1] != sum) {
+            return false;
+        }
+        int steering = (in[IDENTIFIER_SIZE + 4] << 8) | in[IDENTIFIER_SIZE + 5];
+        int light = (in[IDENTIFIER_SIZE + 6] << 8) | in[IDENTIFIER_SIZE + 7];
+        control.speed = (in[IDENTIFIER_SIZE] << 8) | in[IDENTIFIER_SIZE + 1];
+        control.right_turn = steering <= 127 ? steering : 0;
+        control.left_turn = steering > 127 ? 255 - steering : 0;
+        control.light_on = light == light_on_ ? 1 : 0;
+        return true;
+    }
+
+    // Lower-case hex of a packet (2 * PACKET_SIZE chars, not terminated), for logging
+    static void toHex(const Packet& packet, char* out) {
+        for (size_t i = 0; i < PACKET_SIZE; ++i) {
+            out[2 * i] = command_tables::HEX_PAIRS[2 * packet[i]];
+            out[2 * i + 1] = command_tables::HEX_PAIRS[2 * packet[i] + 1];
+        }
+    }
+};
+
+} // namespace rc_car
+
+#endif // COMMAND_ENCODER_H
@@ -0,0 +1,104 @@
+#ifndef COMMAND_SHAPER_H
+#define COMMAND_SHAPER_H
+
+#include <chrono>
+#include "types.h"
+
+namespace rc_car {
+
+enum class ShapingMode {
+    OFF,          // Follow the latest guidance output (steps at the guidance rate unless limited)
+    INTERPOLATE,  // Ramp to each new output over one guidance interval (smooth, one interval of lag)
+    EXTRAPOLATE   // Continue the trend of the last two outputs until the next arrives (no lag, may overshoot;
+                  // without rate/jerk limits it is jerkier than OFF on bench_command_shaping)
+};
+
+// Limits of one channel, in command units; 0 = unlimited
+struct ChannelLimits {
+    double rate;  // Per second
+    double jerk;  // Change of that rate per second
+
+    ChannelLimits() : rate(0.0), jerk(0.0) {}
+    ChannelLimits(double max_rate, double max_jerk) : rate(max_rate), jerk(max_jerk) {}
+};
+
+struct ShapingParams {
+    ShapingMode mode;
+    ChannelLimits speed;     // Signed speed: forward positive, reverse negative
+    ChannelLimits steering;  // Signed steering: right positive, left negative
+    double horizon;          // Extrapolate at most this many guidance intervals, then hold
+
+    ShapingParams() : mode(ShapingMode::OFF), horizon(1.0) {}
+};
+
+// Turns guidance outputs (~30 Hz) into commands at the send rate (200 Hz).
+// Speed and steering are shaped as signed values, so a change of direction
+// passes through zero rather than through the byte encoding's wrap-around.
+// Each send interpolates or extrapolates a reference from the guidance
+// samples, then moves the output towards it within the channel's rate and
+// jerk limits; the jerk limit also brakes the rate ahead of the reference so
+// the output settles with little overshoot. The light follows guidance directly.
+// Speed bytes above MAX_FORWARD_SPEED are read as reverse (255 - speed), so
+// forward commands must stay at or below it while shaping.
+//
+// Used by the send thread only: update() with each guidance output, shape()
+// at each send. No allocation, no locks.
+class CommandShaper {
+private:
+    struct Channel {
+        double sample;       // Latest guidance output
+        double previous;     // The one before it
+        double ramp_from;    // Interpolation start (the reference when the sample arrived)
+        double output;
+        double rate;         // Of the output, per second
+    };
+
+    ShapingParams params_;
+    Channel speed_;
+    Channel steering_;
+    int light_;
+    bool has_sample_;
+    bool has_slope_;
+    bool has_output_;
+    std::chrono::steady_clock::time_point sample_time_;
+    std::chrono::steady_clock::time_point output_time_;
+    double interval_s_;      // Smoothed guidance interval
+    double slope_dt_s_;      // Time between the last two samples
+
+    static constexpr double INITIAL_INTERVAL_S = 1.0 / 30.0;
+    static constexpr double MAX_INTERVAL_S = 0.25;   // Longer gaps are a stall, not a guidance rate
+    static constexpr double INTERVAL_SMOOTHING = 0.2;
+
+    double reference(const Channel& channel, double since_sample_s) const;
+    static void limit(Channel& channel, double reference, const ChannelLimits& limits, double dt);
+
+    static double signedSpeed(const ControlVector& control);
+    static double signedSteering(const ControlVector& control);
+
+public:
+    static constexpr int MAX_FORWARD_SPEED = 127;
+
+    CommandShaper();
+
+    void setParams(const ShapingParams& params) { params_ = params; }
+    const ShapingParams& getParams() const { return params_; }
+    bool isEnabled() const {
+        return params_.mode != ShapingMode::OFF || params_.speed.rate > 0.0 || params_.speed.jerk > 0.0 ||
+               params_.steering.rate > 0.0 || params_.steering.jerk > 0.0;
+    }
+
+    // Start over from `current` (already at the car), e.g. after an emergency stop
+    void reset(const ControlVector& current);
+
+    // A new guidance output arrived at `time`
+    void update(const ControlVector& target, std::chrono::steady_clock::time_point time);
+
+    // Command to send at `now`
+    ControlVector shape(std::chrono::steady_clock::time_point now);
+
+    double getGuidanceInterval() const { return interval_s_; }
+};
+
+} // namespace rc_car
+
+#endif // COMMAND_SHAPER_H
@@ -7,6 +7,7 @@
 #include "camera_capture.h"
 #include "object_tracker.h"
 #include "boundary_detection.h"
+#include "speed_controller.h"
 #include "ble_handler.h"
 #include "config_manager.h"
 #include "types.h"
@@ -20,6 +21,7 @@ private:
     std::unique_ptr<BoundaryDetection> guidance_;
     std::unique_ptr<BLEHandler> ble_handler_;
     std::unique_ptr<ConfigManager> config_;
+    SpeedController speed_control_;  // Guidance thread only
     
     // Threads
     std::thread tracking_thread_;
@@ -40,6 +42,7 @@ private:
     // Configuration
     TrackerType tracker_type_;
     int base_speed_;
+    int max_forward_speed_;  // Cap on guidance speed commands (lower with command shaping)
     bool show_ui_;
     
     // Thread functions
@@ -70,8 +73,9 @@ public:
     // Manual control (for testing)
     void setManualControl(const ControlVector& control);
     
-    // Emergency stop
+    // Emergency stop: latched until cleared
     void emergencyStop();
+    void clearEmergencyStop();
 };
 
 } // namespace rc_car
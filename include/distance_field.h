@@ -0,0 +1,49 @@
+#ifndef DISTANCE_FIELD_H
+#define DISTANCE_FIELD_H
+
+#include <opencv2/opencv.hpp>
+#include "types.h"
+#include "ray_caster.h"
+
+namespace rc_car {
+
+// Euclidean distance field over a static track boundary mask.
+// Built once from a frame (or refreshed on demand) and then queried per frame:
+// ray distances are answered by sphere tracing, so a ray costs a handful of
+// lookups instead of one pixel read per step.
+class DistanceField {
+private:
+    cv::Mat distance_;  // CV_32FC1: distance (pixels) to the nearest boundary pixel
+
+    // Distance to the nearest boundary pixel or frame edge (frame edge counts as a wall)
+    float clearanceAt(int x, int y) const;
+
+public:
+    DistanceField() = default;
+
+    // Build from a boundary mask (CV_8UC1, non-zero = boundary). With max_distance > 0 the field
+    // is capped there, which keeps every boundary change local enough for update().
+    void build(const cv::Mat& boundary_mask, int max_distance = 0);
+    
+    // Re-derive the field after the mask changed inside `region`. Requires a field built with the
+    // same max_distance; recomputes only the region grown by max_distance.
+    void update(const cv::Mat& boundary_mask, const cv::Rect& region, int max_distance);
+    void clear();
+
+    bool isValid() const { return !distance_.empty(); }
+    cv::Size size() const { return distance_.size(); }
+
+    // Distance to the nearest wall (boundary pixel or frame edge), 0 outside the frame
+    float distanceToWall(const Position& pos) const;
+
+    // Sphere-traced equivalent of MaskRayCaster::castRay: returns the first sample
+    // index in [min_distance, max_distance) that hits a boundary or leaves the frame,
+    // or max_distance if the ray is clear
+    int castRay(const Position& start, const RayDirection& dir, int min_distance, int max_distance) const;
+
+    const cv::Mat& distance() const { return distance_; }
+};
+
+} // namespace rc_car
+
+#endif // DISTANCE_FIELD_H
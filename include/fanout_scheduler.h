@@ -0,0 +1,127 @@
+#ifndef FANOUT_SCHEDULER_H
+#define FANOUT_SCHEDULER_H
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "types.h"
+#include "ble_transport.h"
+#include "command_encoder.h"
+
+namespace rc_car {
+
+struct VehicleParams {
+    std::string name;
+    int rate_hz;     // Command rate when the adapter has room
+    int priority;    // Share of a short adapter budget, weighted priority + 1 (negative counts as 0)
+
+    VehicleParams() : rate_hz(200), priority(0) {}
+    VehicleParams(const std::string& vehicle_name, int rate, int prio)
+        : name(vehicle_name), rate_hz(rate), priority(prio) {}
+};
+
+struct VehicleStats {
+    long sent;
+    long busy;               // The link's own transmit queue was full
+    long failed;
+    long offline;            // Slots skipped because the link was down
+    long deferred;           // Slots dropped because the adapter budget went to other links
+    long reconnects;         // Links re-established while running
+    double achieved_hz;
+    double mean_lateness_us; // Send time after the slot's deadline
+    double max_lateness_us;
+
+    VehicleStats()
+        : sent(0), busy(0), failed(0), offline(0), deferred(0), reconnects(0), achieved_hz(0.0),
+          mean_lateness_us(0.0), max_lateness_us(0.0) {}
+};
+
+// Experimental: only bench_fanout uses it so far, and it is not part of the
+// VisionBasedRCCarControl build. It has no stop latch like BLEHandler's, so a stop is
+// just the next command for that car.
+//
+// Sends the commands of several cars through one adapter from a single thread.
+// Every link has its own deadline grid at its rate. Due links are served in
+// start-time fair queuing order: each send moves a link's tag on by 1 / weight,
+// so when the budget runs short every link still gets a share that grows
+// with its weight (priority + 1) and none is starved; equal tags go to the one
+// waiting longest. The adapter budget (writes per second over all links) is a
+// token bucket; a link that misses slots because of it skips them rather than
+// sending a catch-up burst, since only its latest command matters.
+//
+// Links that drop while running are reconnected by a helper thread, so a
+// blocking connect never holds up the other cars; the scheduler counts the
+// link's slots as offline meanwhile and never writes to it.
+//
+// Vehicles are added before start(); commands are handed over lock-free.
+class FanoutScheduler {
+private:
+    struct Vehicle {
+        VehicleParams params;
+        CommandEncoder encoder;
+        std::unique_ptr<BLETransport> transport;
+        ControlSlot control;
+        std::chrono::steady_clock::duration period;
+        std::chrono::steady_clock::time_point deadline;
+        VehicleStats stats;           // Guarded by stats_mutex_
+        double lateness_sum_us;
+        double weight;
+        double start_tag;             // Fair queuing tags (scheduler thread)
+        double finish_tag;
+    };
+
+    std::vector<std::unique_ptr<Vehicle>> vehicles_;
+    std::vector<Vehicle*> due_;       // Scheduler scratch, sized at start()
+    int budget_pps_;                  // 0 = unlimited
+    int burst_;                       // Token bucket depth
+    double virtual_time_;             // Start tag of the last send
+    int reconnect_ms_;                // 0 = dropped links stay offline
+
+    std::atomic<bool> running_;
+    std::thread thread_;
+    std::thread reconnect_thread_;
+    std::mutex wake_mutex_;
+    std::condition_variable wake_cv_;
+    mutable std::mutex stats_mutex_;
+    std::chrono::steady_clock::time_point started_;
+    std::chrono::steady_clock::time_point stopped_;
+
+    void run();
+    void reconnectLoop();
+    void sendTo(Vehicle& vehicle, std::chrono::steady_clock::time_point now);
+
+public:
+    // budget_pps: adapter writes per second shared by all links; burst: writes it may bunch up
+    explicit FanoutScheduler(int budget_pps = 0, int burst = 4);
+    ~FanoutScheduler();
+
+    FanoutScheduler(const FanoutScheduler&) = delete;
+    FanoutScheduler& operator=(const FanoutScheduler&) = delete;
+
+    // Returns the vehicle index, or -1 (while running, or without a transport)
+    int addVehicle(const VehicleParams& params, std::unique_ptr<BLETransport> transport,
+                   const CommandEncoder& encoder = CommandEncoder());
+    size_t vehicleCount() const { return vehicles_.size(); }
+
+    // Blocking, before start(); false if any link failed (those are skipped as offline)
+    bool connectAll();
+    // How often links that are down are retried while running (before start)
+    void setReconnectInterval(int ms) { reconnect_ms_ = std::max(0, ms); }
+
+    void start();
+    void stop();
+    bool isRunning() const { return running_; }
+
+    void setControl(int vehicle, const ControlVector& control);
+    VehicleStats getStats(int vehicle) const;
+};
+
+} // namespace rc_car
+
+#endif // FANOUT_SCHEDULER_H
@@ -0,0 +1,64 @@
+#ifndef GROUND_PROJECTION_H
+#define GROUND_PROJECTION_H
+
+#include <opencv2/opencv.hpp>
+#include <string>
+#include "mapped_file.h"
+
+namespace rc_car {
+
+// Camera calibration for the bird's-eye (ground plane) view
+struct GroundCalibration {
+    double camera_matrix[9];   // Row-major intrinsics
+    double distortion[5];      // k1, k2, p1, p2, k3
+    double homography[9];      // Undistorted image pixel -> bird's-eye pixel, row-major
+    int frame_width;           // Camera resolution the calibration belongs to
+    int frame_height;
+    int width;                 // Bird's-eye grid
+    int height;
+    double units_per_pixel;    // Ground units (mm) per bird's-eye pixel
+};
+
+// Lens undistortion plus ground homography baked into fixed-point cv::remap
+// tables (CV_16SC2 coordinates + CV_16UC1 interpolation index) over the
+// bird's-eye grid. Tables are written once by tools/ground_calibrate and
+// memory-mapped at startup; only the window guidance needs is warped per
+// frame, so pixel distances become ground distances without a full-frame warp.
+class GroundProjection {
+private:
+    GroundCalibration calib_;
+    double inverse_[9];        // Bird's-eye pixel -> undistorted image pixel
+    MappedFile mapping_;       // Whole file when loaded from disk
+    cv::Mat map_xy_;           // CV_16SC2: integer source pixel per bird's-eye pixel
+    cv::Mat map_frac_;         // CV_16UC1: sub-pixel interpolation table index
+
+    bool setCalibration(const GroundCalibration& calib);
+
+public:
+    GroundProjection();
+
+    // Bake the remap tables for a calibration
+    bool build(const GroundCalibration& calib);
+
+    bool save(const std::string& path) const;
+    bool load(const std::string& path);
+    void clear();
+
+    bool isValid() const { return !map_xy_.empty(); }
+    cv::Size size() const { return map_xy_.size(); }
+    cv::Size frameSize() const { return cv::Size(calib_.frame_width, calib_.frame_height); }
+    double unitsPerPixel() const { return calib_.units_per_pixel; }
+    const GroundCalibration& calibration() const { return calib_; }
+
+    // Camera frame pixel <-> bird's-eye pixel
+    cv::Point2f toGround(const cv::Point2f& image_point) const;
+    cv::Point2f toImage(const cv::Point2f& ground_point) const;
+
+    // Bird's-eye view of `region` (grid coordinates, clipped by the caller) of a camera frame.
+    // Pixels the camera does not see are black, so they read as boundary.
+    void warp(const cv::Mat& frame, const cv::Rect& region, cv::Mat& out) const;
+};
+
+} // namespace rc_car
+
+#endif // GROUND_PROJECTION_H
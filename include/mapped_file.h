@@ -0,0 +1,33 @@
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <string>
+#include <cstddef>
+#include <cstdint>
+
+namespace rc_car {
+
+// Read-only memory mapping of a whole file (POSIX mmap), unmapped on destruction.
+// Used by the binary track artefacts so loading is a page-table operation, not a copy.
+class MappedFile {
+private:
+    void* data_;
+    size_t size_;
+
+public:
+    MappedFile();
+    ~MappedFile();
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool open(const std::string& path);
+    void close();
+
+    bool isOpen() const { return data_ != nullptr; }
+    const uint8_t* data() const { return static_cast<const uint8_t*>(data_); }
+    size_t size() const { return size_; }
+};
+
+} // namespace rc_car
+
+#endif // MAPPED_FILE_H
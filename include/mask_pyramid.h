@@ -0,0 +1,57 @@
+#ifndef MASK_PYRAMID_H
+#define MASK_PYRAMID_H
+
+#include <opencv2/opencv.hpp>
+#include <cstdint>
+#include <vector>
+#include "types.h"
+#include "ray_caster.h"
+
+namespace rc_car {
+
+// Counters for coherent casting (see MaskPyramid::castRayFrom)
+struct CoherentRayStats {
+    uint64_t rays;        // Rays cast in coherent mode
+    uint64_t reused;      // Started from last frame's hit
+    uint64_t closer;      // Reused, but the wall had moved in before that hit
+    uint64_t full;        // Full casts (first frame, pose jump, or the ray turned too far)
+    uint64_t verified;    // Results checked against MaskRayCaster
+    uint64_t mismatches;  // Checked results that differed (the MaskRayCaster result was used)
+
+    CoherentRayStats() : rays(0), reused(0), closer(0), full(0), verified(0), mismatches(0) {}
+};
+
+// Max-mip pyramid over a boundary mask: a pixel of level k is set when any
+// mask pixel of its 2^k x 2^k block is. Rays skip whole free blocks at the
+// coarsest level that is empty, so an open stretch costs a few lookups and
+// ray cost grows roughly with the log of the ray length.
+class MaskPyramid {
+private:
+    std::vector<cv::Mat> levels_;  // levels_[0] shares the mask; CV_8UC1, non-zero = boundary in block
+
+public:
+    static constexpr int MAX_LEVELS = 8;  // Coarsest blocks are 128 px
+    static constexpr int OUTWARD_SAMPLES = 8;  // Plain samples past a previous hit before skipping resumes
+
+    // Build from a boundary mask (CV_8UC1, non-zero = boundary); the mask must outlive the pyramid
+    void build(const cv::Mat& boundary_mask, int levels = MAX_LEVELS);
+    void clear() { levels_.clear(); }
+
+    bool isValid() const { return !levels_.empty(); }
+    int levels() const { return static_cast<int>(levels_.size()); }
+    const cv::Mat& level(int k) const { return levels_[k]; }
+
+    // Same result as MaskRayCaster::castRay over the base mask
+    int castRay(const Position& start, const RayDirection& dir, int min_distance, int max_distance) const;
+
+    // Same result as castRay, starting from last frame's hit `previous` for this ray. The span
+    // [min_distance, previous) is checked with the pyramid, so a wall that moved in is still
+    // found; if it is clear, the ray is marched outward from `previous`, where the wall usually
+    // still is. Sets *closer when the hit lies before `previous`.
+    int castRayFrom(const Position& start, const RayDirection& dir, int min_distance, int max_distance,
+                    int previous, bool* closer = nullptr) const;
+};
+
+} // namespace rc_car
+
+#endif // MASK_PYRAMID_H
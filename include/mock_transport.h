@@ -0,0 +1,86 @@
+#ifndef MOCK_TRANSPORT_H
+#define MOCK_TRANSPORT_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <random>
+#include <vector>
+#include "ble_transport.h"
+#include "command_encoder.h"
+
+namespace rc_car {
+
+// Link impairments of the mock car
+struct MockLinkParams {
+    double latency_ms;   // Fixed one-way delay
+    double jitter_ms;    // Extra delay, uniform in [0, jitter]
+    double loss;         // Probability that a command never arrives
+    unsigned seed;       // Loss and jitter are reproducible for a seed
+    size_t history;      // Received commands kept for the harness
+
+    MockLinkParams() : latency_ms(0.0), jitter_ms(0.0), loss(0.0), seed(1), history(4096) {}
+};
+
+// A command as the car saw it
+struct ReceivedCommand {
+    CommandEncoder::Packet packet;
+    std::chrono::steady_clock::time_point sent;
+    std::chrono::steady_clock::time_point delivered;
+};
+
+struct MockLinkStats {
+    long written;
+    long lost;
+    double mean_latency_ms;   // Of delivered commands, including jitter and queueing behind earlier ones
+    double max_latency_ms;
+
+    MockLinkStats() : written(0), lost(0), mean_latency_ms(0.0), max_latency_ms(0.0) {}
+};
+
+// Stand-in for the car behind BLEHandler: every write is timestamped, dropped with
+// probability `loss`, and otherwise delivered after latency plus jitter. Like a
+// real link, delivery is in order, so a late command also holds back the ones
+// sent after it. The received stream stays in a fixed ring (no allocation per
+// write) from which a harness drains commands as they arrive, or a simulator
+// asks which command was in effect at a given time.
+class MockTransport : public BLETransport {
+private:
+    MockLinkParams params_;
+    mutable std::mutex mutex_;
+    std::mt19937 rng_;
+    std::uniform_real_distribution<double> unit_;
+    std::vector<ReceivedCommand> ring_;
+    uint64_t stored_;      // Commands ever stored (ring position = stored_ % size)
+    uint64_t drained_;     // Commands handed to takeDelivered()
+    std::chrono::steady_clock::time_point last_delivery_;
+    std::atomic<bool> connected_;
+
+    long written_;
+    long lost_;
+    double latency_sum_ms_;
+    double max_latency_ms_;
+
+public:
+    explicit MockTransport(const MockLinkParams& params = MockLinkParams());
+
+    bool connect() override;
+    void disconnect() override;
+    bool isConnected() const override { return connected_; }
+    WriteResult write(const uint8_t* data, size_t size) override;
+
+    // Commands delivered by `now` since the last call, in arrival order
+    size_t takeDelivered(std::vector<ReceivedCommand>& out,
+                         std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now());
+
+    // Latest command delivered at or before `time`; false if none has arrived (or it left the ring)
+    bool commandAt(std::chrono::steady_clock::time_point time, CommandEncoder::Packet& packet) const;
+
+    MockLinkStats getStats() const;
+    const MockLinkParams& getParams() const { return params_; }
+};
+
+} // namespace rc_car
+
+#endif // MOCK_TRANSPORT_H
@@ -0,0 +1,56 @@
+#ifndef POLICY_TABLE_H
+#define POLICY_TABLE_H
+
+#include <opencv2/opencv.hpp>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include "mapped_file.h"
+
+namespace rc_car {
+
+// Ray distances precomputed over a (x, y, heading) grid of a static track.
+// On a fixed track the ray-cast result depends only on the car pose, so
+// guidance reduces to one trilinear lookup. Tables are written once and
+// memory-mapped read-only at startup.
+class PolicyTable {
+private:
+    std::vector<uint16_t> storage_;  // Owned samples when built in memory
+    MappedFile mapping_;             // Whole file when loaded from disk
+    const uint16_t* data_;           // [row][col][heading][ray]
+
+    int cell_size_;
+    int cols_;
+    int rows_;
+    int headings_;
+    int min_length_;
+    int max_length_;
+    std::vector<double> ray_angles_;
+
+public:
+    PolicyTable();
+
+    // Cast every ray from every cell centre at every heading bin over a boundary mask
+    // (CV_8UC1, non-zero = boundary). Rows are split across `threads` workers (0 = all cores).
+    bool build(const cv::Mat& boundary_mask, const std::vector<double>& ray_angles, int cell_size,
+               int headings, int min_length, int max_length, int threads = 0);
+
+    bool save(const std::string& path) const;
+    bool load(const std::string& path);
+    void clear();
+
+    bool isValid() const { return data_ != nullptr; }
+    int cellSize() const { return cell_size_; }
+    int headings() const { return headings_; }
+    int minLength() const { return min_length_; }
+    int maxLength() const { return max_length_; }
+    cv::Size coverage() const { return cv::Size(cols_ * cell_size_, rows_ * cell_size_); }
+    const std::vector<double>& rayAngles() const { return ray_angles_; }
+
+    // Trilinearly interpolated distance of every ray at a pose; false outside the grid
+    bool lookup(float x, float y, double heading_deg, int* distances) const;
+};
+
+} // namespace rc_car
+
+#endif // POLICY_TABLE_H
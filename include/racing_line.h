@@ -0,0 +1,57 @@
+#ifndef RACING_LINE_H
+#define RACING_LINE_H
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include "track_centreline.h"
+
+namespace rc_car {
+
+struct RacingLineParams {
+    int iterations;            // Smoothing iterations of the minimum-curvature band
+    float margin;              // Pixels kept clear of the boundary
+    float max_speed;           // Speed command on straights
+    float min_speed;           // Speed command floor in the tightest corners
+    float full_speed_radius;   // Corner radius (px) that can be taken at max_speed
+    float accel;               // Speed^2 gain per pixel when accelerating
+    float brake;               // Speed^2 loss per pixel when braking
+
+    RacingLineParams()
+        : iterations(500), margin(10.0f), max_speed(40.0f), min_speed(10.0f),
+          full_speed_radius(300.0f), accel(2.0f), brake(4.0f) {}
+};
+
+// Racing line and curvature-limited speed profile computed offline from the
+// track centreline. The runtime only looks up the nearest line point, so the
+// guidance loop does no image work at all.
+class RacingLine {
+private:
+    TrackCentreline line_;        // Optimised line (reuses the centreline's spatial index)
+    std::vector<uint8_t> speed_;  // Speed command per point
+    std::vector<float> curvature_;
+
+    void computeCurvature();
+    void computeSpeedProfile(const RacingLineParams& params);
+
+public:
+    RacingLine() = default;
+
+    bool optimise(const TrackCentreline& centreline, const RacingLineParams& params);
+
+    // Compact binary table: header + 6 bytes per point (1/16 px coordinates, speed, clearance).
+    // Coordinates are 16 bits, so save() fails for a line beyond 2047 px.
+    bool save(const std::string& path) const;
+    bool load(const std::string& path);
+
+    bool isValid() const { return line_.isValid() && speed_.size() == line_.size(); }
+    void clear();
+
+    const TrackCentreline& line() const { return line_; }
+    int speedAt(int index) const { return (index >= 0 && index < static_cast<int>(speed_.size())) ? speed_[index] : 0; }
+    float curvatureAt(int index) const { return (index >= 0 && index < static_cast<int>(curvature_.size())) ? curvature_[index] : 0.0f; }
+};
+
+} // namespace rc_car
+
+#endif // RACING_LINE_H
@@ -0,0 +1,42 @@
+#ifndef RAY_CASTER_H
+#define RAY_CASTER_H
+
+#include <opencv2/opencv.hpp>
+#include <cstdint>
+#include "types.h"
+
+namespace rc_car {
+
+// Ray direction in 32.32 fixed point, computed once per ray per frame.
+// The signed double components are kept for samples that land within
+// rounding distance of a pixel edge (see MaskRayCaster::castRay).
+struct RayDirection {
+    double dx;
+    double dy;
+    uint64_t step_x;   // |dx| * 2^32
+    uint64_t step_y;   // |dy| * 2^32
+    int sign_x;
+    int sign_y;
+
+    RayDirection() : dx(1.0), dy(0.0), step_x(0), step_y(0), sign_x(1), sign_y(1) {}
+    explicit RayDirection(double angle_deg);
+};
+
+// Ray caster over an 8-bit single-channel boundary mask (non-zero = boundary).
+// Rays are walked with integer DDA stepping; sample i is at
+// start + (int)(d * i) on each axis, the same pixels the floating-point
+// caster visits, so results are bit-exact with it.
+class MaskRayCaster {
+public:
+    // Returns the first sample index in [min_distance, max_distance) that hits a
+    // boundary pixel or leaves the mask, or max_distance if the ray is clear
+    static int castRay(const cv::Mat& mask, const Position& start, const RayDirection& dir,
+                       int min_distance, int max_distance);
+
+    // Pixel visited by sample i (the one castRay tests)
+    static Position sampleAt(const Position& start, const RayDirection& dir, int i);
+};
+
+} // namespace rc_car
+
+#endif // RAY_CASTER_H
@@ -0,0 +1,121 @@
+#ifndef SPEED_CONTROLLER_H
+#define SPEED_CONTROLLER_H
+
+#include <chrono>
+
+namespace rc_car {
+
+enum class SpeedMode {
+    OPEN_LOOP,   // Guidance speed is sent as the command (prototype behaviour)
+    CLOSED_LOOP  // Guidance speed is a target velocity; feed-forward from the learned map + PI on the tracked velocity
+};
+
+struct SpeedParams {
+    double kp;              // Command correction per unit of velocity error, normalised by the map gain
+    double ki;              // Per second, same normalisation
+    double target_scale;    // Target velocity per guidance speed unit (0 = the warm-up map defines it)
+    double warmup_seconds;  // Open-loop driving used to learn the command -> velocity map
+    int warmup_command;     // Centre of the warm-up schedule (0 = the speed requested when warm-up starts)
+    int warmup_dither;      // +/- command units alternated during warm-up so the map sees two levels
+    double filter_seconds;  // Time constant of the velocity low-pass
+    double forgetting;      // Per-sample weight decay of the map fit and its closed-loop scale (tracks battery drain)
+    int max_command;        // Closed-loop command ceiling
+
+    SpeedParams()
+        : kp(0.5), ki(1.0), target_scale(0.0), warmup_seconds(10.0), warmup_command(0), warmup_dither(5),
+          filter_seconds(0.2), forgetting(0.998), max_command(100) {}
+};
+
+// Linear command -> velocity map: velocity = gain * command + offset (offset < 0 is the dead band)
+struct SpeedMap {
+    double gain = 0.0;
+    double offset = 0.0;
+    bool valid = false;
+
+    double velocity(double command) const { return gain * command + offset; }
+    double command(double velocity) const { return (velocity - offset) / gain; }
+};
+
+// Closes the loop on the car's tracked velocity. Positions come from the
+// tracker (ground millimetres when a ground projection is loaded, pixels
+// otherwise) and are differentiated and low-passed into a velocity.
+//
+// The first warmup_seconds of driving are open loop with a small square-wave
+// dither on the command; steady-state (command, velocity) pairs are fitted to
+// the linear map by exponentially weighted least squares. From then on the
+// requested speed is turned into a target velocity, the map inverts it into a
+// feed-forward command and a PI term removes what the map gets wrong. In
+// closed loop the map's overall scale keeps adapting with forgetting, so it
+// follows the battery as it drains.
+class SpeedController {
+private:
+    SpeedMode mode_;
+    SpeedParams params_;
+
+    // Velocity estimate
+    bool has_position_;
+    double last_x_;
+    double last_y_;
+    std::chrono::steady_clock::time_point last_observed_;
+    bool has_velocity_;
+    double velocity_;
+
+    // Map fit: exponentially weighted sums over (command, velocity) samples
+    double sum_w_;
+    double sum_c_;
+    double sum_v_;
+    double sum_cc_;
+    double sum_cv_;
+    SpeedMap nominal_;   // Fit at the end of warm-up; defines target velocities when target_scale is 0
+    double scale_;       // Velocity now / velocity at warm-up for the same command
+    SpeedMap map_;       // nominal_ scaled by scale_
+
+    // Warm-up and loop state
+    bool warming_up_;
+    bool warmup_started_;
+    bool warmup_extended_;
+    std::chrono::steady_clock::time_point warmup_start_;
+    int warmup_base_;    // Command the warm-up dither is centred on
+    int held_command_;
+    std::chrono::steady_clock::time_point held_since_;
+    double integral_;
+    bool has_update_;
+    std::chrono::steady_clock::time_point last_update_;
+
+    static constexpr double SETTLE_S = 1.0;      // A command must be held this long before it is sampled
+    static constexpr double STALE_S = 0.5;       // Older velocities are not trusted
+    static constexpr double DITHER_PERIOD_S = 2.0;
+    static constexpr double MIN_SPREAD = 1.0;    // Command std-dev (units) needed for a fit
+    static constexpr double MIN_SCALE = 0.5;     // Closed-loop map scale range: beyond it the car is
+    static constexpr double MAX_SCALE = 2.0;     // blocked or mis-tracked, not running on a different battery
+
+    void sample(int command, std::chrono::steady_clock::time_point now);
+    bool fit();
+    int hold(int command, std::chrono::steady_clock::time_point now);
+
+public:
+    SpeedController();
+
+    void setMode(SpeedMode mode) { mode_ = mode; }
+    SpeedMode getMode() const { return mode_; }
+    void setParams(const SpeedParams& params) { params_ = params; }
+    const SpeedParams& getParams() const { return params_; }
+
+    // Tracked car position (any consistent unit) at its capture time
+    void observe(double x, double y, std::chrono::steady_clock::time_point time);
+
+    // Command for a guidance speed request (0-255)
+    int update(int requested_speed, std::chrono::steady_clock::time_point now);
+
+    // Drop the velocity estimate and PI state (e.g. tracking lost); the learned map is kept
+    void reset();
+
+    bool isCalibrating() const { return warming_up_; }
+    bool hasVelocity() const { return has_velocity_; }
+    double velocity() const { return velocity_; }
+    const SpeedMap& getMap() const { return map_; }
+};
+
+} // namespace rc_car
+
+#endif // SPEED_CONTROLLER_H
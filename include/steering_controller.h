@@ -0,0 +1,116 @@
+#ifndef STEERING_CONTROLLER_H
+#define STEERING_CONTROLLER_H
+
+#include <chrono>
+#include <vector>
+
+namespace rc_car {
+
+enum class SteeringMode {
+    BANG_BANG,  // Prototype behaviour: fixed evasive turns, otherwise heading mapped linearly
+    PID,        // PID on heading + cross-track error
+    MPC         // Short-horizon model-predictive control over a kinematic bicycle model
+};
+
+struct SteeringParams {
+    double kp;                 // Full-lock fractions per degree of error
+    double ki;                 // Per degree-cycle
+    double kd;                 // Per degree/cycle
+    double cross_track_gain;   // Degrees of heading error per pixel of cross-track error
+    double full_lock_angle;    // Road-wheel angle (deg) at full steering
+    double wheelbase;          // Pixels
+    int horizon;               // MPC prediction steps (guidance cycles)
+    int budget_us;             // Hard per-cycle solver budget
+    double heading_weight;     // MPC stage cost per deg^2 of heading error
+    double cross_track_weight; // MPC stage cost per px^2 of lateral offset
+    double effort_weight;      // MPC cost per (full-lock fraction)^2
+    double rate_weight;        // MPC cost per (change of full-lock fraction)^2 between steps
+
+    SteeringParams()
+        : kp(0.02), ki(0.0005), kd(0.01), cross_track_gain(0.2), full_lock_angle(60.0), wheelbase(40.0),
+          horizon(10), budget_us(500), heading_weight(0.1), cross_track_weight(1.0),
+          effort_weight(20.0), rate_weight(2000.0) {}
+};
+
+struct SteeringStats {
+    unsigned long cycles = 0;
+    unsigned long iterations = 0;    // MPC solver iterations over all cycles
+    unsigned long budget_hits = 0;   // Cycles where the solver stopped at the budget
+    double max_solve_us = 0.0;
+};
+
+// Continuous steering from guidance errors. The heading error is the angle
+// (deg, positive = right) between the car's heading and where guidance wants
+// to go; the cross-track error is the lateral offset (px, positive = the free
+// space is to the right) from the middle of the free space. Output is the
+// steering command as a fraction of full lock in [-1, 1], positive = right.
+//
+// The MPC solves for a steering sequence over `horizon` cycles by projected
+// Gauss-Newton (a horizon x horizon Cholesky solve per iteration), warm-started
+// from the previous cycle's solution shifted by one step. The iteration loop
+// checks the clock and stops at `budget_us`, so a slow cycle returns the best
+// sequence so far instead of blowing the guidance deadline; the warm start
+// means few iterations are needed in steady state.
+//
+// The PID derivative is taken on the error, so a caller that switches what the
+// error is measured against calls retarget() first: the jump is then not
+// differentiated into a kick.
+class SteeringController {
+private:
+    SteeringMode mode_;
+    SteeringParams params_;
+    SteeringStats stats_;
+
+    // PID state
+    double integral_;
+    double prev_error_;
+    double prev_output_;
+    bool primed_;              // prev_error_ / warm start hold a previous cycle
+    bool retargeted_;          // The error's reference changed: no derivative this cycle
+    std::chrono::steady_clock::time_point last_update_;
+
+    // MPC warm start and solver scratch
+    std::vector<double> plan_;
+    std::vector<double> trial_;
+    std::vector<double> heading_;        // Predicted heading error per step (deg)
+    std::vector<double> offset_;         // Predicted cross-track error per step (px)
+    std::vector<double> gradient_;
+    std::vector<double> direction_;
+    std::vector<double> hessian_;        // horizon x horizon, row-major
+    std::vector<double> sens_heading_;
+    std::vector<double> sens_offset_;
+
+    static constexpr int MAX_ITERATIONS = 20;
+    static constexpr double CONVERGED = 1e-4;    // Largest plan change (full-lock fraction) that stops the solver
+    static constexpr double RESET_GAP_S = 0.5;   // Longer gaps between cycles drop all state
+
+    double updatePid(double heading_error, double cross_track_error);
+    double updateMpc(double heading_error, double cross_track_error, double speed);
+    // Cost of a plan from the current errors; leaves the predicted states in heading_ / offset_
+    double planCost(double heading_error, double cross_track_error, double speed, const std::vector<double>& plan);
+    // Gauss-Newton direction for plan_ (predicted states must describe plan_)
+    bool newtonStep(double speed);
+
+public:
+    SteeringController();
+
+    void setMode(SteeringMode mode) { mode_ = mode; reset(); }
+    SteeringMode getMode() const { return mode_; }
+    void setParams(const SteeringParams& params);
+    const SteeringParams& getParams() const { return params_; }
+
+    // Forget the integral, derivative and warm start (e.g. after tracking was lost)
+    void reset();
+
+    // The next error is against a different target: skip its derivative, keep the rest
+    void retarget() { retargeted_ = true; }
+
+    // One guidance cycle; speed is the car's speed in pixels per cycle
+    double update(double heading_error, double cross_track_error, double speed);
+
+    const SteeringStats& getStats() const { return stats_; }
+};
+
+} // namespace rc_car
+
+#endif // STEERING_CONTROLLER_H
@@ -0,0 +1,56 @@
+#ifndef TILED_BOUNDARY_MASK_H
+#define TILED_BOUNDARY_MASK_H
+
+#include <opencv2/opencv.hpp>
+#include <vector>
+
+namespace rc_car {
+
+// Boundary mask kept up to date tile by tile. A downsampled grayscale copy of
+// the frame is compared against the one each tile was last thresholded from;
+// only tiles whose content changed beyond a threshold are converted and
+// re-thresholded. Tiles under the car are never updated, so the car itself
+// does not leak into the mask.
+class TiledBoundaryMask {
+private:
+    cv::Mat mask_;        // CV_8UC1, 255 = boundary
+    cv::Mat reference_;   // Downsampled gray each tile was last thresholded from
+    cv::Mat sample_;      // Downsampled gray of the current frame
+    cv::Mat small_;       // Downsampled frame (before gray conversion)
+    cv::Mat diff_;
+    cv::Mat tile_gray_;
+    cv::Mat tile_mask_;
+
+    int tile_size_;
+    int diff_threshold_;   // Gray levels a sample must move by to dirty its tile
+    int black_threshold_;
+    std::vector<cv::Rect> dirty_;
+
+    static constexpr int SAMPLE_STEP = 4;  // Change detector looks at every 4th pixel on both axes
+
+    void toGray(const cv::Mat& frame, cv::Mat& gray) const;
+    void thresholdRegion(const cv::Mat& frame, const cv::Rect& region);
+    void rebuild(const cv::Mat& frame, const cv::Rect& exclude);
+
+public:
+    TiledBoundaryMask();
+
+    void setTileSize(int pixels) { tile_size_ = std::max(SAMPLE_STEP, pixels / SAMPLE_STEP * SAMPLE_STEP); }
+    void setDiffThreshold(int levels) { diff_threshold_ = std::max(0, levels); }
+
+    // Force a full re-threshold on the next update
+    void invalidate() { mask_.release(); }
+
+    // Bring the mask up to date with `frame` (gray < black_threshold = boundary). Tiles that overlap
+    // `exclude` are left as they are. Returns the regions whose mask was rewritten this frame.
+    const std::vector<cv::Rect>& update(const cv::Mat& frame, int black_threshold, const cv::Rect& exclude);
+
+    bool isValid() const { return !mask_.empty(); }
+    const cv::Mat& mask() const { return mask_; }
+    const std::vector<cv::Rect>& dirtyTiles() const { return dirty_; }
+    int tileSize() const { return tile_size_; }
+};
+
+} // namespace rc_car
+
+#endif // TILED_BOUNDARY_MASK_H
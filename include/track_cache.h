@@ -0,0 +1,44 @@
+#ifndef TRACK_CACHE_H
+#define TRACK_CACHE_H
+
+#include <opencv2/opencv.hpp>
+#include <string>
+#include <functional>
+#include <cstdint>
+
+namespace rc_car {
+
+// Directory of derived track artefacts (centreline, racing line, policy table).
+// Files are keyed by a hash of the source track image and of the parameters
+// each artefact depends on, so changing either simply misses the cache.
+class TrackCache {
+private:
+    std::string directory_;
+    uint64_t image_hash_;
+    bool has_image_;
+
+public:
+    static constexpr uint64_t FNV_OFFSET_BASIS = 14695981039346656037ULL;
+    static constexpr uint64_t FNV_PRIME = 1099511628211ULL;
+
+    TrackCache();
+
+    void setDirectory(const std::string& directory) { directory_ = directory; }
+    void setSourceImage(const cv::Mat& image);
+    void clearSourceImage() { has_image_ = false; }
+    bool isEnabled() const { return !directory_.empty() && has_image_; }
+
+    // <directory>/<name>-<16 hex digit key><extension>, or empty when the cache is disabled
+    std::string path(const std::string& name, const std::string& params, const std::string& extension) const;
+
+    // Save through a temporary file of this writer's own and rename it into place, so readers
+    // never see a partial artefact and concurrent writers never interleave
+    bool store(const std::string& path, const std::function<bool(const std::string&)>& save) const;
+
+    // 64-bit FNV-1a
+    static uint64_t hash(const void* data, size_t size, uint64_t seed = FNV_OFFSET_BASIS);
+};
+
+} // namespace rc_car
+
+#endif // TRACK_CACHE_H
@@ -0,0 +1,73 @@
+#ifndef TRACK_CENTRELINE_H
+#define TRACK_CENTRELINE_H
+
+#include <opencv2/opencv.hpp>
+#include <vector>
+#include <string>
+#include "types.h"
+
+namespace rc_car {
+
+// Ordered centreline of the drivable track region, extracted once from a
+// boundary mask (skeleton of the region containing the car) and resampled to
+// evenly spaced waypoints. A uniform grid over the waypoints answers
+// nearest-waypoint queries without scanning the polyline.
+class TrackCentreline {
+private:
+    std::vector<cv::Point2f> waypoints_;
+    std::vector<float> clearance_;   // Distance to the nearest boundary at each waypoint
+    bool closed_;                    // Loop track (last waypoint connects to the first)
+    float spacing_;
+
+    // Spatial index: waypoint indices bucketed by grid cell (CSR layout)
+    int cell_size_;
+    int grid_cols_;
+    int grid_rows_;
+    std::vector<int> cell_offsets_;
+    std::vector<int> cell_indices_;
+
+    void buildIndex();
+
+public:
+    TrackCentreline();
+
+    // Extract from a boundary mask (CV_8UC1, non-zero = boundary). `seed` must lie on the track;
+    // boundary pixels within `seed_radius` of it (the car itself) are ignored.
+    bool extract(const cv::Mat& boundary_mask, const Position& seed, int seed_radius = 0,
+                 float spacing = 5.0f);
+
+    // Adopt an existing ordered polyline (e.g. loaded from disk); spacing 0 = measured from the first two waypoints
+    void setWaypoints(const std::vector<cv::Point2f>& waypoints, const std::vector<float>& clearance, bool closed,
+                      float spacing = 0.0f);
+
+    // Points `spacing` apart along the arc length of a polyline. `values` (one per point, or
+    // empty) are interpolated alongside; a loop does not end on a duplicate of its first point.
+    static void resample(const std::vector<cv::Point2f>& points, const std::vector<float>& values, bool closed,
+                         float spacing, std::vector<cv::Point2f>& out, std::vector<float>& out_values);
+    void clear();
+
+    // Binary file: header + (x, y, clearance) floats per waypoint
+    bool save(const std::string& path) const;
+    bool load(const std::string& path);
+
+    bool isValid() const { return waypoints_.size() >= 2; }
+    bool isClosed() const { return closed_; }
+    size_t size() const { return waypoints_.size(); }
+    float spacing() const { return spacing_; }
+    const std::vector<cv::Point2f>& waypoints() const { return waypoints_; }
+    const std::vector<float>& clearance() const { return clearance_; }
+
+    // Index of the waypoint nearest to p (-1 if the centreline is empty)
+    int nearestWaypoint(const cv::Point2f& p) const;
+
+    // Index `steps` waypoints further along the line in the given direction (+1 / -1);
+    // wraps on closed tracks and clamps at the ends of open ones
+    int advance(int index, int steps, int direction = 1) const;
+
+    // Unit tangent at a waypoint in the +1 direction
+    cv::Point2f tangent(int index) const;
+};
+
+} // namespace rc_car
+
+#endif // TRACK_CENTRELINE_H
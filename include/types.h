@@ -11,9 +11,12 @@
 #include <opencv2/opencv.hpp>
 #include <string>
 #include <array>
+#include <atomic>
+#include <cstdint>
 #include <queue>
 #include <mutex>
 #include <condition_variable>
+#include <chrono>
 #include <cmath>
 
 #ifndef M_PI
@@ -62,6 +65,7 @@ struct TrackingResult {
     Position midpoint;
     MovementVector movement;
     bool tracking_lost;
+    std::chrono::steady_clock::time_point timestamp;  // When the frame was captured
     
     TrackingResult() : tracking_lost(false) {}
 };
@@ -76,6 +80,81 @@ struct ControlVector {
     ControlVector() : light_on(0), speed(0), right_turn(0), left_turn(0) {}
     ControlVector(int light, int spd, int right, int left) 
         : light_on(light), speed(spd), right_turn(right), left_turn(left) {}
+    
+    bool operator==(const ControlVector& other) const {
+        return light_on == other.light_on && speed == other.speed &&
+               right_turn == other.right_turn && left_turn == other.left_turn;
+    }
+    bool operator!=(const ControlVector& other) const { return !(*this == other); }
+};
+
+enum class SlotWrite {
+    UNCHANGED,
+    CHANGED,
+    LATCHED    // Refused: the slot holds a latched command
+};
+
+// Latest-value hand-off of a ControlVector without a lock: the four fields are
+// packed 16 bits each (clamped to 0..65535, the packet's field width; the light
+// to 0..32767) into one 64-bit atomic. Readers always see a whole vector, and a
+// producer can never block the sender or be blocked by it.
+//
+// The top bit of the light field is a latch: latch() stores a command that
+// store() and update() then refuse to replace until unlatch(). The check and the
+// write are one atomic step, so no command can slip in after the latch.
+class ControlSlot {
+private:
+    std::atomic<uint64_t> packed_;
+
+    static_assert(std::atomic<uint64_t>::is_always_lock_free, "ControlSlot needs a lock-free 64-bit atomic");
+
+    static constexpr uint64_t LATCH_BIT = uint64_t(1) << 15;
+
+    static uint64_t field(int value, int max = 0xffff) {
+        return static_cast<uint64_t>(value < 0 ? 0 : (value > max ? max : value));
+    }
+    static uint64_t pack(const ControlVector& control) {
+        return field(control.light_on, 0x7fff) | (field(control.speed) << 16) |
+               (field(control.right_turn) << 32) | (field(control.left_turn) << 48);
+    }
+    static ControlVector unpack(uint64_t packed) {
+        return ControlVector(static_cast<int>(packed & 0x7fff), static_cast<int>((packed >> 16) & 0xffff),
+                             static_cast<int>((packed >> 32) & 0xffff), static_cast<int>(packed >> 48));
+    }
+
+public:
+    ControlSlot() : packed_(0) {}
+
+    ControlVector load() const { return unpack(packed_.load(std::memory_order_acquire)); }
+    bool isLatched() const { return (packed_.load(std::memory_order_acquire) & LATCH_BIT) != 0; }
+
+    SlotWrite store(const ControlVector& control) {
+        return update([&control](ControlVector& stored) { stored = control; });
+    }
+
+    // Read-modify-write of some fields (CAS loop)
+    template <typename Modify>
+    SlotWrite update(Modify modify) {
+        uint64_t expected = packed_.load(std::memory_order_relaxed);
+        uint64_t desired;
+        do {
+            if (expected & LATCH_BIT) {
+                return SlotWrite::LATCHED;
+            }
+            ControlVector control = unpack(expected);
+            modify(control);
+            desired = pack(control);
+            if (desired == expected) {
+                return SlotWrite::UNCHANGED;
+            }
+        } while (!packed_.compare_exchange_weak(expected, desired, std::memory_order_acq_rel,
+                                                std::memory_order_relaxed));
+        return SlotWrite::CHANGED;
+    }
+
+    // Unconditional; latch() holds `control` until unlatch()
+    void latch(const ControlVector& control) { packed_.store(pack(control) | LATCH_BIT, std::memory_order_release); }
+    void unlatch(const ControlVector& control) { packed_.store(pack(control), std::memory_order_release); }
 };
 
 // Ray for boundary detection
@@ -0,0 +1,211 @@
+/**
+ * @file batch_ray_caster.cpp
+ * @brief Vectorised batch ray casting over a bit-packed boundary mask
+ */
+
+#include "batch_ray_caster.h"
+#include "batch_ray_lanes.h"
+#include <cmath>
+#include <algorithm>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+namespace rc_car {
+
+namespace {
+
+using batch_lanes::FRACTION_BITS;
+using batch_lanes::LaneDirection;
+
+constexpr int MAX_RAY_LENGTH = 32767;  // Keeps the accumulators below 2^31
+
+// The AVX2 kernel is built for AVX2 in its own file; it only runs on CPUs that have it
+bool useAVX2() {
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+    static const bool supported = batch_lanes::avx2KernelBuilt() && __builtin_cpu_supports("avx2");
+    return supported;
+#else
+    return false;
+#endif
+}
+
+LaneDirection makeLane(double angle_deg) {
+    double angle_rad = angle_deg * M_PI / 180.0;
+    double dx = std::cos(angle_rad);
+    double dy = std::sin(angle_rad);
+
+    LaneDirection lane;
+    lane.step_x = static_cast<uint32_t>(std::lround(std::ldexp(std::abs(dx), FRACTION_BITS)));
+    lane.step_y = static_cast<uint32_t>(std::lround(std::ldexp(std::abs(dy), FRACTION_BITS)));
+    lane.sign_x = dx < 0 ? -1 : 1;
+    lane.sign_y = dy < 0 ? -1 : 1;
+    return lane;
+}
+
+int castLane(const PackedBoundaryMask& mask, const Position& start, const LaneDirection& lane,
+             int min_distance, int max_distance) {
+    uint32_t acc_x = lane.step_x * static_cast<uint32_t>(min_distance);
+    uint32_t acc_y = lane.step_y * static_cast<uint32_t>(min_distance);
+
+    for (int i = min_distance; i < max_distance; ++i) {
+        int x = start.x + lane.sign_x * static_cast<int>(acc_x >> FRACTION_BITS);
+        int y = start.y + lane.sign_y * static_cast<int>(acc_y >> FRACTION_BITS);
+
+        if (x < 0 || x >= mask.cols() || y < 0 || y >= mask.rows() || mask.test(x, y)) {
+            return i;
+        }
+
+        acc_x += lane.step_x;
+        acc_y += lane.step_y;
+    }
+    return max_distance;
+}
+
+#if defined(__ARM_NEON)
+// Four rays per iteration; NEON has no gather, so coordinates are vectorised
+// and the mask words are loaded per lane
+void castBlockNEON(const PackedBoundaryMask& mask, const Position& start, const LaneDirection* lanes,
+                   int min_distance, int max_distance, int* distances) {
+    uint32_t step_x[4], step_y[4];
+    int32_t sign_x[4], sign_y[4];
+    for (int k = 0; k < 4; ++k) {
+        step_x[k] = lanes[k].step_x;
+        step_y[k] = lanes[k].step_y;
+        sign_x[k] = lanes[k].sign_x;
+        sign_y[k] = lanes[k].sign_y;
+    }
+
+    const uint32x4_t v_step_x = vld1q_u32(step_x);
+    const uint32x4_t v_step_y = vld1q_u32(step_y);
+    const int32x4_t v_sign_x = vld1q_s32(sign_x);
+    const int32x4_t v_sign_y = vld1q_s32(sign_y);
+    const int32x4_t v_start_x = vdupq_n_s32(start.x);
+    const int32x4_t v_start_y = vdupq_n_s32(start.y);
+
+    uint32x4_t acc_x = vmulq_n_u32(v_step_x, static_cast<uint32_t>(min_distance));
+    uint32x4_t acc_y = vmulq_n_u32(v_step_y, static_cast<uint32_t>(min_distance));
+    bool done[4] = {false, false, false, false};
+    int remaining = 4;
+    for (int k = 0; k < 4; ++k) {
+        distances[k] = max_distance;
+    }
+
+    for (int i = min_distance; i < max_distance && remaining > 0; ++i) {
+        int32_t xs[4], ys[4];
+        vst1q_s32(xs, vaddq_s32(v_start_x, vmulq_s32(vreinterpretq_s32_u32(vshrq_n_u32(acc_x, FRACTION_BITS)), v_sign_x)));
+        vst1q_s32(ys, vaddq_s32(v_start_y, vmulq_s32(vreinterpretq_s32_u32(vshrq_n_u32(acc_y, FRACTION_BITS)), v_sign_y)));
+
+        for (int k = 0; k < 4; ++k) {
+            if (done[k]) {
+                continue;
+            }
+            if (xs[k] < 0 || xs[k] >= mask.cols() || ys[k] < 0 || ys[k] >= mask.rows() ||
+                mask.test(xs[k], ys[k])) {
+                distances[k] = i;
+                done[k] = true;
+                --remaining;
+            }
+        }
+
+        acc_x = vaddq_u32(acc_x, v_step_x);
+        acc_y = vaddq_u32(acc_y, v_step_y);
+    }
+}
+#endif
+
+} // namespace
+
+void PackedBoundaryMask::pack(const cv::Mat& mask) {
+    cols_ = mask.cols;
+    rows_ = mask.rows;
+    words_per_row_ = (cols_ + 31) / 32;
+    words_.assign(static_cast<size_t>(rows_) * words_per_row_, 0u);
+
+    for (int y = 0; y < rows_; ++y) {
+        const uchar* src = mask.ptr<uchar>(y);
+        uint32_t* dst = &words_[static_cast<size_t>(y) * words_per_row_];
+        int x = 0;
+#if defined(__SSE2__)
+        // 32 mask bytes -> one word via two byte movemasks
+        const __m128i zero = _mm_setzero_si128();
+        for (; x + 32 <= cols_; x += 32) {
+            __m128i lo = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + x));
+            __m128i hi = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + x + 16));
+            uint32_t zero_bits = static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(lo, zero))) |
+                                 (static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(hi, zero))) << 16);
+            dst[x >> 5] = ~zero_bits;
+        }
+#endif
+        for (; x < cols_; ++x) {
+            if (src[x]) {
+                dst[x >> 5] |= 1u << (x & 31);
+            }
+        }
+    }
+}
+
+void BatchRayCaster::castRaysScalar(const PackedBoundaryMask& mask, const Position& start,
+                                    const double* angles_deg, int count,
+                                    int min_distance, int max_distance, int* distances) {
+    for (int k = 0; k < count; ++k) {
+        distances[k] = castLane(mask, start, makeLane(angles_deg[k]), min_distance, max_distance);
+    }
+}
+
+void BatchRayCaster::castRays(const PackedBoundaryMask& mask, const Position& start,
+                              const double* angles_deg, int count,
+                              int min_distance, int max_distance, int* distances) {
+    if (mask.empty() || count <= 0) {
+        for (int k = 0; k < count; ++k) {
+            distances[k] = min_distance;
+        }
+        return;
+    }
+
+    max_distance = std::min(max_distance, MAX_RAY_LENGTH);
+
+    int k = 0;
+    if (useAVX2()) {
+        const batch_lanes::MaskView view = {mask.data(), mask.cols(), mask.rows(), mask.wordsPerRow()};
+        LaneDirection lanes[8];
+        for (; k + 8 <= count; k += 8) {
+            for (int j = 0; j < 8; ++j) {
+                lanes[j] = makeLane(angles_deg[k + j]);
+            }
+            batch_lanes::castBlockAVX2(view, start.x, start.y, lanes, min_distance, max_distance, distances + k);
+        }
+    }
+#if defined(__ARM_NEON)
+    LaneDirection lanes[4];
+    for (; k + 4 <= count; k += 4) {
+        for (int j = 0; j < 4; ++j) {
+            lanes[j] = makeLane(angles_deg[k + j]);
+        }
+        castBlockNEON(mask, start, lanes, min_distance, max_distance, distances + k);
+    }
+#endif
+
+    castRaysScalar(mask, start, angles_deg + k, count - k, min_distance, max_distance, distances + k);
+}
+
+const char* BatchRayCaster::backendName() {
+    if (useAVX2()) {
+        return "AVX2";
+    }
+#if defined(__ARM_NEON)
+    return "NEON";
+#else
+    return "scalar";
+#endif
+}
+
+} // namespace rc_car
@@ -0,0 +1,88 @@
+/**
+ * @file batch_ray_caster_avx2.cpp
+ * @brief AVX2 kernel of the batch ray caster, built with -mavx2 and picked at runtime
+ */
+
+#include "batch_ray_lanes.h"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+namespace rc_car {
+namespace batch_lanes {
+
+#if defined(__AVX2__)
+bool avx2KernelBuilt() {
+    return true;
+}
+
+// Eight rays per iteration; one gathered mask word per lane per step
+void castBlockAVX2(const MaskView& mask, int start_x, int start_y, const LaneDirection* lanes,
+                   int min_distance, int max_distance, int* distances) {
+    alignas(32) int32_t step_x[8], step_y[8], sign_x[8], sign_y[8];
+    for (int k = 0; k < 8; ++k) {
+        step_x[k] = static_cast<int32_t>(lanes[k].step_x);
+        step_y[k] = static_cast<int32_t>(lanes[k].step_y);
+        sign_x[k] = lanes[k].sign_x;
+        sign_y[k] = lanes[k].sign_y;
+    }
+
+    const __m256i v_step_x = _mm256_load_si256(reinterpret_cast<const __m256i*>(step_x));
+    const __m256i v_step_y = _mm256_load_si256(reinterpret_cast<const __m256i*>(step_y));
+    const __m256i v_sign_x = _mm256_load_si256(reinterpret_cast<const __m256i*>(sign_x));
+    const __m256i v_sign_y = _mm256_load_si256(reinterpret_cast<const __m256i*>(sign_y));
+    const __m256i v_start_x = _mm256_set1_epi32(start_x);
+    const __m256i v_start_y = _mm256_set1_epi32(start_y);
+    const __m256i v_cols = _mm256_set1_epi32(mask.cols);
+    const __m256i v_rows = _mm256_set1_epi32(mask.rows);
+    const __m256i v_words_per_row = _mm256_set1_epi32(mask.words_per_row);
+    const __m256i v_minus_one = _mm256_set1_epi32(-1);
+    const __m256i v_one = _mm256_set1_epi32(1);
+    const __m256i v_31 = _mm256_set1_epi32(31);
+    const int* base = reinterpret_cast<const int*>(mask.words);
+
+    __m256i acc_x = _mm256_mullo_epi32(v_step_x, _mm256_set1_epi32(min_distance));
+    __m256i acc_y = _mm256_mullo_epi32(v_step_y, _mm256_set1_epi32(min_distance));
+    __m256i result = _mm256_set1_epi32(max_distance);
+    __m256i done = _mm256_setzero_si256();
+
+    for (int i = min_distance; i < max_distance; ++i) {
+        __m256i x = _mm256_add_epi32(v_start_x, _mm256_sign_epi32(_mm256_srli_epi32(acc_x, FRACTION_BITS), v_sign_x));
+        __m256i y = _mm256_add_epi32(v_start_y, _mm256_sign_epi32(_mm256_srli_epi32(acc_y, FRACTION_BITS), v_sign_y));
+
+        __m256i inside = _mm256_and_si256(
+            _mm256_and_si256(_mm256_cmpgt_epi32(x, v_minus_one), _mm256_cmpgt_epi32(v_cols, x)),
+            _mm256_and_si256(_mm256_cmpgt_epi32(y, v_minus_one), _mm256_cmpgt_epi32(v_rows, y)));
+
+        // Lanes outside the frame are not gathered (and count as hits)
+        __m256i index = _mm256_add_epi32(_mm256_mullo_epi32(y, v_words_per_row), _mm256_srli_epi32(x, 5));
+        __m256i words = _mm256_mask_i32gather_epi32(_mm256_setzero_si256(), base, index, inside, 4);
+        __m256i bits = _mm256_and_si256(_mm256_srlv_epi32(words, _mm256_and_si256(x, v_31)), v_one);
+
+        __m256i hit = _mm256_or_si256(_mm256_andnot_si256(inside, v_minus_one), _mm256_cmpeq_epi32(bits, v_one));
+        __m256i first_hit = _mm256_andnot_si256(done, hit);
+        result = _mm256_blendv_epi8(result, _mm256_set1_epi32(i), first_hit);
+        done = _mm256_or_si256(done, hit);
+
+        if (_mm256_movemask_ps(_mm256_castsi256_ps(done)) == 0xFF) {
+            break;
+        }
+
+        acc_x = _mm256_add_epi32(acc_x, v_step_x);
+        acc_y = _mm256_add_epi32(acc_y, v_step_y);
+    }
+
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(distances), result);
+}
+#else
+bool avx2KernelBuilt() {
+    return false;
+}
+
+void castBlockAVX2(const MaskView&, int, int, const LaneDirection*, int, int, int*) {
+}
+#endif
+
+} // namespace batch_lanes
+} // namespace rc_car
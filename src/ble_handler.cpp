@@ -1,50 +1,87 @@
 #include "ble_handler.h"
+#include <algorithm>
+#include <cmath>
 #include <iostream>
-#include <iomanip>
-#include <sstream>
 #include <chrono>
 #include <thread>
 
 namespace rc_car {
 
+namespace {
+
+int64_t steadyNowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+} // namespace
+
 BLEHandler::BLEHandler()
     : device_mac_("f9:af:3c:e2:d2:f5"),
       device_characteristic_uuid_("6e400002-b5a3-f393-e0a9-e50e24dcca9e"),
-      device_identifier_("bf0a00082800"),
-      connected_(false), running_(false), command_send_rate_hz_(200) {
+      transport_injected_(false), random_address_(true), connection_timeout_ms_(10000),
+      sent_(0), busy_(0), failed_(0), offline_(0),
+      connected_(false), running_(false), control_updates_(0), change_time_ns_(0), resend_request_(false),
+      command_send_rate_hz_(200),
+      send_policy_(SendPolicy::FIXED_RATE), keepalive_ms_(100), coalesce_ms_(0.0),
+      stop_request_ns_(0), stop_burst_(5), stop_burst_interval_ms_(7.5), blocked_commands_(0),
+      managing_(false), reconnect_attempts_(0), backoff_initial_ms_(250), backoff_max_ms_(5000),
+      link_state_(LinkState::DISCONNECTED), link_connects_(0), link_failed_attempts_(0), link_outages_(0),
+      in_outage_(false), last_outage_s_(0.0), max_outage_s_(0.0), total_outage_s_(0.0),
+      timing_cycles_(0), timing_overruns_(0), timing_intervals_(0),
+      interval_sum_us_(0.0), deviation_sq_sum_us_(0.0), deviation_max_us_(0.0),
+      change_sends_(0), keepalive_sends_(0), latency_sum_us_(0.0), latency_max_us_(0.0),
+      stop_requests_(0), stop_burst_packets_(0), stop_latency_sum_us_(0.0), stop_latency_max_us_(0.0) {
 }
 
 BLEHandler::BLEHandler(const std::string& mac_address, const std::string& characteristic_uuid)
     : device_mac_(mac_address),
       device_characteristic_uuid_(characteristic_uuid),
-      device_identifier_("bf0a00082800"),
-      connected_(false), running_(false), command_send_rate_hz_(200) {
+      transport_injected_(false), random_address_(true), connection_timeout_ms_(10000),
+      sent_(0), busy_(0), failed_(0), offline_(0),
+      connected_(false), running_(false), control_updates_(0), change_time_ns_(0), resend_request_(false),
+      command_send_rate_hz_(200),
+      send_policy_(SendPolicy::FIXED_RATE), keepalive_ms_(100), coalesce_ms_(0.0),
+      stop_request_ns_(0), stop_burst_(5), stop_burst_interval_ms_(7.5), blocked_commands_(0),
+      managing_(false), reconnect_attempts_(0), backoff_initial_ms_(250), backoff_max_ms_(5000),
+      link_state_(LinkState::DISCONNECTED), link_connects_(0), link_failed_attempts_(0), link_outages_(0),
+      in_outage_(false), last_outage_s_(0.0), max_outage_s_(0.0), total_outage_s_(0.0),
+      timing_cycles_(0), timing_overruns_(0), timing_intervals_(0),
+      interval_sum_us_(0.0), deviation_sq_sum_us_(0.0), deviation_max_us_(0.0),
+      change_sends_(0), keepalive_sends_(0), latency_sum_us_(0.0), latency_max_us_(0.0),
+      stop_requests_(0), stop_burst_packets_(0), stop_latency_sum_us_(0.0), stop_latency_max_us_(0.0) {
 }
 
 BLEHandler::~BLEHandler() {
+    stopConnectionManager();
     stopSending();
     disconnect();
 }
 
 bool BLEHandler::initialize(const std::string& mac_address, const std::string& characteristic_uuid) {
+    if (connected_) {
+        std::cerr << "Warning: Cannot change the BLE device while connected" << std::endl;
+        return false;
+    }
     device_mac_ = mac_address;
     device_characteristic_uuid_ = characteristic_uuid;
+    if (!transport_injected_) {
+        transport_.reset();  // Recreated for the new address on connect
+    }
     return true;
 }
 
 bool BLEHandler::connect() {
-    if (connected_) {
+    if (isConnected()) {
         return true;
     }
+    if (managing_) {
+        return false;  // The connection manager owns the link
+    }
     
     std::cout << "Connecting to BLE device: " << device_mac_ << std::endl;
     
-    // TODO: Implement actual BLE connection using chosen library
-    // This is a placeholder implementation
-    // For BlueZ, you would use D-Bus API or bluetoothctl/gatttool
-    // For simpleble-cpp, you would use SimpleBLE library
-    
-    bool success = connectToDevice();
+    bool success = (transport_ || createTransport()) && transport_->connect();
     
     if (success) {
         connected_ = true;
@@ -61,6 +98,7 @@ void BLEHandler::disconnect() {
         return;
     }
     
+    stopConnectionManager();
     stopSending();
     disconnectFromDevice();
     connected_ = false;
@@ -68,13 +106,38 @@ void BLEHandler::disconnect() {
 }
 
 void BLEHandler::setControl(const ControlVector& control) {
-    std::lock_guard<std::mutex> lock(control_mutex_);
-    current_control_ = control;
+    SlotWrite result = control_.store(control);
+    if (result == SlotWrite::UNCHANGED) {
+        // An unchanged guidance output is still a sample for the shaper
+        control_updates_.fetch_add(1, std::memory_order_release);
+    }
+    noteWrite(result);
+}
+
+void BLEHandler::noteChange() {
+    control_updates_.fetch_add(1, std::memory_order_release);
+    if (send_policy_ != SendPolicy::ON_CHANGE) {
+        return;
+    }
+    // Stamp only the first unsent change; the sender consumes the stamp before reading the slot
+    int64_t none = 0;
+    if (change_time_ns_.compare_exchange_strong(none, steadyNowNs())) {
+        // Taking the mutex orders this against the sender's predicate check, so the wake-up is not lost
+        { std::lock_guard<std::mutex> lock(wake_mutex_); }
+        control_cv_.notify_one();
+    }
+}
+
+void BLEHandler::noteWrite(SlotWrite result) {
+    if (result == SlotWrite::CHANGED) {
+        noteChange();
+    } else if (result == SlotWrite::LATCHED) {
+        blocked_commands_.fetch_add(1, std::memory_order_relaxed);
+    }
 }
 
 ControlVector BLEHandler::getControl() const {
-    std::lock_guard<std::mutex> lock(control_mutex_);
-    return current_control_;
+    return control_.load();
 }
 
 void BLEHandler::startSending() {
@@ -87,6 +150,20 @@ void BLEHandler::startSending() {
         return;
     }
     
+    {
+        std::lock_guard<std::mutex> lock(timing_mutex_);
+        timing_cycles_ = 0;
+        timing_overruns_ = 0;
+        timing_intervals_ = 0;
+        interval_sum_us_ = 0.0;
+        deviation_sq_sum_us_ = 0.0;
+        deviation_max_us_ = 0.0;
+        change_sends_ = 0;
+        keepalive_sends_ = 0;
+        latency_sum_us_ = 0.0;
+        latency_max_us_ = 0.0;
+    }
+    
     running_ = true;
     send_thread_ = std::thread(&BLEHandler::sendLoop, this);
 }
@@ -96,152 +173,522 @@ void BLEHandler::stopSending() {
         return;
     }
     
-    running_ = false;
+    {
+        std::lock_guard<std::mutex> lock(wake_mutex_);
+        running_ = false;
+    }
+    control_cv_.notify_all();
     if (send_thread_.joinable()) {
         send_thread_.join();
     }
 }
 
 void BLEHandler::sendLoop() {
-    auto sleep_duration = std::chrono::microseconds(1000000 / command_send_rate_hz_);
+    // Both policies serve a pending stop before anything else, so one requested
+    // while no loop ran goes out first
+    if (send_policy_ == SendPolicy::ON_CHANGE) {
+        sendOnChange();
+    } else {
+        sendFixedRate();
+    }
+    
+    // A stop requested while the loop was exiting still goes out, from this thread
+    bool failing = false;
+    serviceStop(failing);
+}
+
+bool BLEHandler::transmit(const ControlVector& control, bool& failing) {
+    // Checked again right before the write: a stop latched since the caller read
+    // (or shaped) its command goes out instead, and its burst follows
+    ControlVector command = control_.isLatched() ? ControlVector() : control;
+    last_sent_.store(command);
+    CommandEncoder::Packet packet;
+    encoder_.encode(command, packet);
+    
+    // Report the first failure of a run, not every one at the send rate
+    bool sent = sendCommand(packet);
+    if (!sent && !failing) {
+        std::cerr << "Warning: Failed to send BLE command" << std::endl;
+    }
+    failing = !sent;
+    return sent;
+}
+
+void BLEHandler::sendFixedRate() {
+    // Absolute deadlines on a fixed grid: the time a send takes does not stretch the
+    // period, and after an overrun the missed slots are skipped instead of sent back to back
+    using Clock = std::chrono::steady_clock;
+    int rate_hz = 0;
+    Clock::duration period;
+    Clock::time_point deadline;
+    Clock::time_point last_send;
+    bool have_last = false;
+    bool failing = false;
+    
+    // The shaper continues from what the car last got; the current command counts as a fresh sample
+    uint64_t seen_updates = control_updates_.load(std::memory_order_acquire) - 1;
+    shaper_.reset(last_sent_.load());
     
     while (running_) {
-        ControlVector control;
-        {
-            std::lock_guard<std::mutex> lock(control_mutex_);
-            control = current_control_;
+        int requested_hz = command_send_rate_hz_;
+        if (requested_hz > 0 && requested_hz != rate_hz) {
+            // New rate: start a new grid from now
+            rate_hz = requested_hz;
+            period = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / rate_hz));
+            deadline = Clock::now();
+            have_last = false;
+        }
+        
+        if (serviceStop(failing)) {
+            // The burst took this slot; resume on a new grid after it
+            deadline = Clock::now() + period;
+            have_last = false;
+            shaper_.reset(ControlVector());
+        } else {
+            Clock::time_point now = Clock::now();
+            double interval_us = have_last ? std::chrono::duration<double, std::micro>(now - last_send).count() : 0.0;
+            last_send = now;
+            
+            ControlVector control;
+            if (control_.isLatched()) {
+                shaper_.reset(control);  // Ramp up from standstill once the stop is cleared
+            } else if (shaper_.isEnabled()) {
+                uint64_t updates = control_updates_.load(std::memory_order_acquire);
+                ControlVector target = control_.load();
+                if (updates != seen_updates) {
+                    seen_updates = updates;
+                    shaper_.update(target, now);
+                }
+                control = shaper_.shape(now);
+            } else {
+                control = control_.load();
+            }
+            if (stop_request_ns_ != 0) {
+                continue;  // A stop came in meanwhile: its burst goes first, this command not at all
+            }
+            transmit(control, failing);
+            
+            deadline += period;
+            long skipped = 0;
+            now = Clock::now();
+            if (deadline <= now) {
+                skipped = static_cast<long>((now - deadline) / period) + 1;
+                deadline += skipped * period;
+            }
+            
+            {
+                std::lock_guard<std::mutex> lock(timing_mutex_);
+                ++timing_cycles_;
+                timing_overruns_ += skipped;
+                if (have_last) {
+                    double deviation = std::abs(interval_us - std::chrono::duration<double, std::micro>(period).count());
+                    ++timing_intervals_;
+                    interval_sum_us_ += interval_us;
+                    deviation_sq_sum_us_ += deviation * deviation;
+                    deviation_max_us_ = std::max(deviation_max_us_, deviation);
+                }
+            }
+            have_last = true;
+        }
+        
+        // Sleep to the deadline unless a stop request arrives first; a resend after a
+        // reconnect goes out in between and leaves the grid where it is
+        std::unique_lock<std::mutex> lock(wake_mutex_);
+        while (control_cv_.wait_until(lock, deadline, [this] {
+                   return stop_request_ns_ != 0 || resend_request_ || !running_;
+               }) && stop_request_ns_ == 0 && running_) {
+            resend_request_ = false;
+            lock.unlock();
+            resendLatest(failing);
+            lock.lock();
+        }
+    }
+}
+
+void BLEHandler::sendOnChange() {
+    // Idle until setControl() changes the command or the keepalive falls due. With
+    // coalescing, change sends are at least one connection interval apart: changes
+    // arriving in between ride along with the next send instead of queueing up
+    // behind the radio.
+    using Clock = std::chrono::steady_clock;
+    const auto keepalive = std::chrono::milliseconds(std::max(1, keepalive_ms_));
+    const auto coalesce = std::chrono::duration_cast<Clock::duration>(
+        std::chrono::duration<double, std::milli>(std::max(0.0, coalesce_ms_)));
+    Clock::time_point last_send;
+    bool have_last = false;
+    bool failing = false;
+    
+    std::unique_lock<std::mutex> lock(wake_mutex_);
+    while (running_) {
+        if (change_time_ns_ == 0 && stop_request_ns_ == 0 && !resend_request_) {
+            Clock::time_point keepalive_at = have_last ? last_send + keepalive : Clock::now();
+            control_cv_.wait_until(lock, keepalive_at, [this] {
+                return change_time_ns_ != 0 || stop_request_ns_ != 0 || resend_request_ || !running_;
+            });
+            if (!running_) {
+                break;
+            }
+        }
+        
+        if (stop_request_ns_ == 0 && change_time_ns_ != 0 && have_last && coalesce.count() > 0 &&
+            Clock::now() < last_send + coalesce) {
+            control_cv_.wait_until(lock, last_send + coalesce, [this] { return stop_request_ns_ != 0 || !running_; });
+            if (!running_) {
+                break;
+            }
+        }
+        lock.unlock();
+        
+        if (serviceStop(failing)) {
+            change_time_ns_ = 0;  // Anything pending was superseded by the stop
+            last_send = Clock::now();
+            have_last = true;
+            lock.lock();
+            continue;
+        }
+        
+        // A resend after a reconnect is this send (counted as a keepalive unless something changed)
+        resend_request_ = false;
+        int64_t changed_ns = change_time_ns_.exchange(0);
+        bool change = changed_ns != 0;
+        Clock::time_point changed_at(std::chrono::duration_cast<Clock::duration>(std::chrono::nanoseconds(changed_ns)));
+        ControlVector control = control_.load();  // The stop command itself while latched
+        if (stop_request_ns_ != 0) {
+            lock.lock();
+            continue;  // A stop came in meanwhile: its burst goes first
         }
         
-        std::string command = generateCommand(control);
+        transmit(control, failing);
+        last_send = Clock::now();
+        have_last = true;
         
-        if (!sendCommand(command)) {
-            std::cerr << "Warning: Failed to send BLE command" << std::endl;
+        {
+            std::lock_guard<std::mutex> timing_lock(timing_mutex_);
+            ++timing_cycles_;
+            if (change) {
+                double latency_us = std::chrono::duration<double, std::micro>(last_send - changed_at).count();
+                ++change_sends_;
+                latency_sum_us_ += latency_us;
+                latency_max_us_ = std::max(latency_max_us_, latency_us);
+            } else {
+                ++keepalive_sends_;
+            }
         }
         
-        std::this_thread::sleep_for(sleep_duration);
+        lock.lock();
     }
 }
 
-std::string BLEHandler::intToHex(int value, int digits) const {
-    std::stringstream ss;
-    ss << std::hex << std::setfill('0') << std::setw(digits) << value;
-    return ss.str();
+bool BLEHandler::createTransport() {
+    if (transport_injected_) {
+        return transport_ != nullptr;
+    }
+    if (device_mac_.compare(0, 5, "mock:") == 0) {
+        transport_.reset(new MockTransport(mock_link_));
+        return true;
+    }
+    att::Uuid characteristic;
+    if (!att::parseUuid(device_characteristic_uuid_, characteristic)) {
+        std::cerr << "Error: Invalid characteristic UUID: " << device_characteristic_uuid_ << std::endl;
+        return false;
+    }
+    transport_.reset(new AttTransport(device_mac_, characteristic, random_address_, connection_timeout_ms_));
+    return true;
 }
 
-std::string BLEHandler::generateCommand(const ControlVector& control) const {
-    // Command format: DEVICE_IDENTIFIER + SPEED_HEX + DRIFT_HEX + STEERING_HEX + LIGHT_VALUE + CHECKSUM
-    // Based on Python prototype: Command = "".join([DEVICE_IDENTIFIER, twoDigitHex(speed), twoDigitHex(drift), twoDigitHex(steering), LIGHT_VALUE, CHECKSUM])
-    
-    int speed_value = control.speed;
-    int drift_value = 0;  // Typically 0
-    int steering_value = 0;
-    
-    // Calculate steering value (as per Python prototype)
-    if (control.right_turn > 0) {
-        steering_value = control.right_turn;
-    } else if (control.left_turn > 0) {
-        steering_value = 255 - control.left_turn;
+bool BLEHandler::startConnectionManager() {
+    if (managing_) {
+        return true;
+    }
+    if (manager_thread_.joinable()) {
+        manager_thread_.join();  // Gave up earlier; start over
+    }
+    if (!transport_ && !createTransport()) {
+        return false;
     }
     
-    std::string light_value = control.light_on ? "0200" : "0000";
-    std::string checksum = "00";  // Can be calculated if needed
-    
-    std::string command = device_identifier_ +
-                         intToHex(speed_value, 4) +
-                         intToHex(drift_value, 4) +
-                         intToHex(steering_value, 4) +
-                         light_value +
-                         checksum;
-    
-    return command;
+    std::cout << "Connecting to BLE device in the background: " << device_mac_ << std::endl;
+    connected_ = true;  // Session open; the link itself comes and goes
+    managing_ = true;
+    manager_thread_ = std::thread(&BLEHandler::connectionLoop, this);
+    return true;
 }
 
-// Placeholder BLE implementation methods
-// These need to be replaced with actual BLE library calls
+void BLEHandler::stopConnectionManager() {
+    {
+        std::lock_guard<std::mutex> lock(manager_mutex_);
+        managing_ = false;
+    }
+    manager_cv_.notify_all();
+    // An attempt in progress gives up at once rather than at the connection timeout
+    if (transport_) {
+        transport_->abortConnect();
+    }
+    if (manager_thread_.joinable()) {
+        manager_thread_.join();
+    }
+    if (transport_) {
+        transport_->resumeConnect();
+    }
+}
 
-bool BLEHandler::connectToDevice() {
-    // TODO: Implement actual BLE connection
-    // Example for BlueZ via D-Bus or simpleble-cpp:
-    // 
-    // For simpleble-cpp:
-    //   SimpleBLE::Adapter adapter = SimpleBLE::Adapter::get_adapters()[0];
-    //   adapter.scan_for(5000);
-    //   auto peripherals = adapter.scan_get_results();
-    //   for (auto& peripheral : peripherals) {
-    //       if (peripheral.address() == device_mac_) {
-    //           peripheral.connect();
-    //           return true;
-    //       }
-    //   }
-    //
-    // For BlueZ D-Bus:
-    //   Use org.bluez API via D-Bus
+void BLEHandler::connectionLoop() {
+    using Clock = std::chrono::steady_clock;
+    auto backoff = std::chrono::milliseconds(std::max(1, backoff_initial_ms_));
+    const auto backoff_max = std::chrono::milliseconds(std::max(backoff_initial_ms_, backoff_max_ms_));
+    int failures = 0;
+    bool was_connected = false;
     
-    std::cout << "NOTE: BLE connection is a placeholder. Implement with actual BLE library." << std::endl;
-    // For now, simulate connection success for testing
-    return true;  // Change to false to test connection failure
+    std::unique_lock<std::mutex> lock(manager_mutex_);
+    while (managing_) {
+        if (transport_->isConnected()) {
+            manager_cv_.wait_for(lock, std::chrono::milliseconds(LINK_POLL_MS),
+                                 [this] { return !managing_ || !transport_->isConnected(); });
+            continue;
+        }
+        
+        if (was_connected) {
+            was_connected = false;
+            in_outage_ = true;
+            outage_start_ = Clock::now();
+            ++link_outages_;
+            std::cerr << "Warning: BLE link lost, reconnecting" << std::endl;
+        }
+        
+        // The attempt blocks this thread only (up to the connection timeout)
+        link_state_ = LinkState::CONNECTING;
+        lock.unlock();
+        bool success = transport_->connect();
+        lock.lock();
+        
+        if (success) {
+            link_state_ = LinkState::CONNECTED;
+            ++link_connects_;
+            if (in_outage_) {
+                double outage_s = std::chrono::duration<double>(Clock::now() - outage_start_).count();
+                in_outage_ = false;
+                last_outage_s_ = outage_s;
+                max_outage_s_ = std::max(max_outage_s_, outage_s);
+                total_outage_s_ += outage_s;
+                std::cout << "BLE link restored after " << outage_s << " s" << std::endl;
+            } else {
+                std::cout << "Successfully connected to BLE device" << std::endl;
+            }
+            was_connected = true;
+            failures = 0;
+            backoff = std::chrono::milliseconds(std::max(1, backoff_initial_ms_));
+            
+            // The car gets the current command now, not at the next send slot
+            requestResend();
+            continue;
+        }
+        
+        ++link_failed_attempts_;
+        ++failures;
+        link_state_ = LinkState::DISCONNECTED;
+        if (reconnect_attempts_ > 0 && failures >= reconnect_attempts_) {
+            link_state_ = LinkState::GAVE_UP;
+            managing_ = false;  // A later startConnectionManager() joins this thread and starts again
+            std::cerr << "Error: Could not reach BLE device after " << failures << " attempts, giving up" << std::endl;
+            break;
+        }
+        manager_cv_.wait_for(lock, backoff, [this] { return !managing_; });
+        backoff = std::min(backoff * 2, backoff_max);
+    }
+}
+
+void BLEHandler::requestResend() {
+    // The send loop does the write, so the link keeps a single writer; without a
+    // loop there is no command stream to restore
+    if (!running_) {
+        return;
+    }
+    resend_request_ = true;
+    { std::lock_guard<std::mutex> lock(wake_mutex_); }
+    control_cv_.notify_all();
+}
+
+void BLEHandler::resendLatest(bool& failing) {
+    // With shaping the car gets the shaped command it would have had, not a step to the target
+    ControlVector control = shaper_.isEnabled() ? last_sent_.load() : control_.load();
+    transmit(control, failing);
+}
+
+ConnectionStats BLEHandler::getConnectionStats() const {
+    std::lock_guard<std::mutex> lock(manager_mutex_);
+    ConnectionStats stats;
+    if (manager_thread_.joinable()) {
+        stats.state = link_state_;
+    } else {
+        stats.state = isConnected() ? LinkState::CONNECTED : LinkState::DISCONNECTED;
+    }
+    stats.connects = link_connects_;
+    stats.failed_attempts = link_failed_attempts_;
+    stats.outages = link_outages_;
+    if (in_outage_) {
+        stats.current_outage_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - outage_start_).count();
+    }
+    stats.last_outage_s = last_outage_s_;
+    stats.max_outage_s = max_outage_s_;
+    stats.total_outage_s = total_outage_s_;
+    return stats;
+}
+
+void BLEHandler::setTransport(std::unique_ptr<BLETransport> transport) {
+    if (connected_) {
+        std::cerr << "Warning: Cannot replace the BLE transport while connected" << std::endl;
+        return;
+    }
+    transport_ = std::move(transport);
+    transport_injected_ = transport_ != nullptr;
 }
 
 void BLEHandler::disconnectFromDevice() {
-    // TODO: Implement actual BLE disconnection
-    // Example:
-    //   peripheral.disconnect();
+    if (transport_) {
+        transport_->disconnect();
+    }
 }
 
-bool BLEHandler::sendCommand(const std::string& command) {
-    // TODO: Implement actual BLE command sending
-    // Example for simpleble-cpp:
-    //   peripheral.write_request(service_uuid, characteristic_uuid, bytes.fromhex(command));
-    //
-    // Example for BlueZ:
-    //   Use gatttool or D-Bus API
-    
-    // For now, just print the command for debugging
-    static int count = 0;
-    if (++count % 200 == 0) {  // Print every 200 commands (once per second at 200Hz)
-        std::cout << "BLE Command: " << command << std::endl;
+bool BLEHandler::sendCommand(const CommandEncoder::Packet& packet) {
+    if (!transport_) {
+        return false;
+    }
+    if (!transport_->isConnected()) {
+        offline_.fetch_add(1, std::memory_order_relaxed);
+        return false;
     }
     
-    return true;  // Simulate success
+    // A full transmit queue drops this command rather than delaying it; the next
+    // one carries the newer control state anyway
+    switch (transport_->write(packet.data(), packet.size())) {
+    case WriteResult::OK:
+        sent_.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    case WriteResult::BUSY:
+        busy_.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    case WriteResult::FAILED:
+    default:
+        failed_.fetch_add(1, std::memory_order_relaxed);
+        manager_cv_.notify_one();  // Start reconnecting now rather than at the next link check
+        return false;
+    }
+}
+
+SendTimingStats BLEHandler::getTimingStats() const {
+    std::lock_guard<std::mutex> lock(timing_mutex_);
+    SendTimingStats stats;
+    stats.cycles = timing_cycles_;
+    stats.overruns = timing_overruns_;
+    if (timing_intervals_ > 0) {
+        stats.mean_interval_us = interval_sum_us_ / timing_intervals_;
+        stats.jitter_rms_us = std::sqrt(deviation_sq_sum_us_ / timing_intervals_);
+        stats.jitter_max_us = deviation_max_us_;
+    }
+    stats.change_sends = change_sends_;
+    stats.keepalive_sends = keepalive_sends_;
+    if (change_sends_ > 0) {
+        stats.mean_latency_us = latency_sum_us_ / change_sends_;
+        stats.max_latency_us = latency_max_us_;
+    }
+    return stats;
+}
+
+BLEStats BLEHandler::getStats() const {
+    BLEStats stats;
+    stats.sent = sent_.load(std::memory_order_relaxed);
+    stats.busy = busy_.load(std::memory_order_relaxed);
+    stats.failed = failed_.load(std::memory_order_relaxed);
+    stats.offline = offline_.load(std::memory_order_relaxed);
+    return stats;
 }
 
 void BLEHandler::setLight(bool on) {
-    std::lock_guard<std::mutex> lock(control_mutex_);
-    current_control_.light_on = on ? 1 : 0;
+    noteWrite(control_.update([on](ControlVector& control) { control.light_on = on ? 1 : 0; }));
 }
 
 void BLEHandler::setSpeed(int speed) {
-    std::lock_guard<std::mutex> lock(control_mutex_);
-    if (speed >= 0 && speed < 255) {
-        current_control_.speed = speed;
-        current_control_.light_on = 1;  // Lights on when moving
+    if (speed < 0 || speed > maxSpeed()) {
+        return;
     }
+    noteWrite(control_.update([speed](ControlVector& control) {
+        control.speed = speed;
+        control.light_on = 1;  // Lights on when moving
+    }));
 }
 
 void BLEHandler::setReverseSpeed(int speed) {
-    std::lock_guard<std::mutex> lock(control_mutex_);
-    if (speed >= 0 && speed < 255) {
-        current_control_.speed = 255 - speed;  // Reverse mapping
-        current_control_.light_on = 1;
+    if (speed < 0 || speed > maxSpeed()) {
+        return;
     }
+    noteWrite(control_.update([speed](ControlVector& control) {
+        control.speed = 255 - speed;  // Reverse mapping
+        control.light_on = 1;
+    }));
 }
 
 void BLEHandler::setSteering(int left_value, int right_value) {
-    std::lock_guard<std::mutex> lock(control_mutex_);
-    current_control_.left_turn = std::min(left_value, 255);
-    current_control_.right_turn = std::min(right_value, 255);
+    noteWrite(control_.update([left_value, right_value](ControlVector& control) {
+        control.left_turn = std::min(left_value, 255);
+        control.right_turn = std::min(right_value, 255);
+    }));
 }
 
 void BLEHandler::emergencyStop() {
-    std::lock_guard<std::mutex> lock(control_mutex_);
-    current_control_.speed = 0;
-    current_control_.left_turn = 0;
-    current_control_.right_turn = 0;
-    current_control_.light_on = 0;
-    
-    // Send stop command immediately
-    std::string stop_command = generateCommand(current_control_);
-    sendCommand(stop_command);
+    int64_t requested_ns = steadyNowNs();
+    control_.latch(ControlVector());  // From here on producers are refused in the same atomic step
+    
+    // Only the send loop writes to the link, so it sends the burst: a command it is
+    // about to send can no longer land after the stop. Without a loop nothing drives
+    // the car, and the burst waits for the next startSending().
+    int64_t none = 0;
+    stop_request_ns_.compare_exchange_strong(none, requested_ns);
+    { std::lock_guard<std::mutex> lock(wake_mutex_); }
+    control_cv_.notify_all();
+}
+
+void BLEHandler::clearEmergencyStop() {
+    control_.unlatch(ControlVector());
+}
+
+bool BLEHandler::serviceStop(bool& failing) {
+    int64_t requested_ns = stop_request_ns_.exchange(0);
+    if (requested_ns == 0) {
+        return false;
+    }
+    
+    // Repeat the stop so one lost packet cannot leave the car driving
+    int packets = std::max(1, stop_burst_);
+    auto spacing = std::chrono::duration<double, std::milli>(std::max(0.0, stop_burst_interval_ms_));
+    for (int i = 0; i < packets; ++i) {
+        transmit(ControlVector(), failing);
+        if (i == 0) {
+            double latency_us = (steadyNowNs() - requested_ns) / 1000.0;
+            std::lock_guard<std::mutex> lock(timing_mutex_);
+            ++stop_requests_;
+            stop_latency_sum_us_ += latency_us;
+            stop_latency_max_us_ = std::max(stop_latency_max_us_, latency_us);
+        }
+        if (i + 1 < packets && spacing.count() > 0) {
+            std::this_thread::sleep_for(spacing);
+        }
+    }
+    std::lock_guard<std::mutex> lock(timing_mutex_);
+    stop_burst_packets_ += packets;
+    return true;
+}
+
+StopStats BLEHandler::getStopStats() const {
+    std::lock_guard<std::mutex> lock(timing_mutex_);
+    StopStats stats;
+    stats.requests = stop_requests_;
+    stats.burst_packets = stop_burst_packets_;
+    stats.blocked_commands = blocked_commands_.load(std::memory_order_relaxed);
+    if (stop_requests_ > 0) {
+        stats.mean_latency_us = stop_latency_sum_us_ / stop_requests_;
+        stats.max_latency_us = stop_latency_max_us_;
+    }
+    return stats;
 }
 
 } // namespace rc_car
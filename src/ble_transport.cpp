@@ -0,0 +1,375 @@
+/**
+ * @file ble_transport.cpp
+ * @brief GATT client over a raw ATT channel (L2CAP LE socket or local stand-in) with Write Without Response
+ */
+
+#include "ble_transport.h"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <fcntl.h>
+#include <iostream>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace rc_car {
+
+namespace {
+
+// Linux Bluetooth socket ABI (as in BlueZ's bluetooth.h / l2cap.h, which are not required to build)
+constexpr int AF_BLUETOOTH_ = 31;
+constexpr int BTPROTO_L2CAP_ = 0;
+constexpr int SOL_BLUETOOTH_ = 274;
+constexpr int BT_SECURITY_ = 4;
+constexpr uint8_t BT_SECURITY_LOW_ = 1;
+constexpr uint8_t BDADDR_LE_PUBLIC_ = 0x01;
+constexpr uint8_t BDADDR_LE_RANDOM_ = 0x02;
+
+struct SockaddrL2 {
+    sa_family_t l2_family;
+    uint16_t l2_psm;
+    uint8_t l2_bdaddr[6];    // Little-endian: reversed from the printed form
+    uint16_t l2_cid;
+    uint8_t l2_bdaddr_type;
+};
+
+struct BtSecurity {
+    uint8_t level;
+    uint8_t key_size;
+};
+
+constexpr char UNIX_PREFIX[] = "unix:";
+
+int hexValue(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+bool parseMac(const std::string& text, uint8_t* out) {
+    if (text.size() != 17) {
+        return false;
+    }
+    for (int i = 0; i < 6; ++i) {
+        int hi = hexValue(text[3 * i]);
+        int lo = hexValue(text[3 * i + 1]);
+        if (hi < 0 || lo < 0 || (i < 5 && text[3 * i + 2] != ':')) {
+            return false;
+        }
+        out[5 - i] = static_cast<uint8_t>((hi << 4) | lo);
+    }
+    return true;
+}
+
+uint16_t toLe16(uint16_t value) {
+    uint8_t bytes[2];
+    att::putLe16(bytes, value);
+    uint16_t out;
+    std::memcpy(&out, bytes, sizeof(out));
+    return out;
+}
+
+int remainingMs(std::chrono::steady_clock::time_point deadline) {
+    auto left = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now());
+    return static_cast<int>(std::max<long long>(0, left.count()));
+}
+
+} // namespace
+
+namespace att {
+
+bool parseUuid(const std::string& text, Uuid& uuid) {
+    // 32 hex digits with dashes after 8, 12, 16 and 20; wire order is the reverse of the text
+    if (text.size() != 36) {
+        return false;
+    }
+    int byte = 15;
+    for (size_t i = 0; i < text.size();) {
+        if (i == 8 || i == 13 || i == 18 || i == 23) {
+            if (text[i] != '-') {
+                return false;
+            }
+            ++i;
+            continue;
+        }
+        int hi = hexValue(text[i]);
+        int lo = hexValue(text[i + 1]);
+        if (hi < 0 || lo < 0) {
+            return false;
+        }
+        uuid[byte--] = static_cast<uint8_t>((hi << 4) | lo);
+        i += 2;
+    }
+    return byte == -1;
+}
+
+Uuid shortUuid(uint16_t uuid) {
+    // 0000xxxx-0000-1000-8000-00805f9b34fb
+    Uuid out = {{0xfb, 0x34, 0x9b, 0x5f, 0x80, 0x00, 0x00, 0x80, 0x00, 0x10, 0x00, 0x00, 0, 0, 0x00, 0x00}};
+    putLe16(&out[12], uuid);
+    return out;
+}
+
+} // namespace att
+
+AttTransport::AttTransport(const std::string& address, const att::Uuid& characteristic, bool random_address, int timeout_ms)
+    : address_(address), characteristic_(characteristic), random_address_(random_address),
+      timeout_ms_(timeout_ms), fd_(-1), pending_fd_(-1), value_handle_(0), aborted_(false) {
+    if (pipe2(wake_pipe_, O_NONBLOCK | O_CLOEXEC) < 0) {
+        wake_pipe_[0] = wake_pipe_[1] = -1;  // Attempts still end at their timeout
+    }
+}
+
+AttTransport::~AttTransport() {
+    disconnect();
+    for (int fd : wake_pipe_) {
+        if (fd >= 0) {
+            close(fd);
+        }
+    }
+}
+
+bool AttTransport::openSocket() {
+    int fd;
+    int result;
+    if (address_.compare(0, sizeof(UNIX_PREFIX) - 1, UNIX_PREFIX) == 0) {
+        std::string path = address_.substr(sizeof(UNIX_PREFIX) - 1);
+        sockaddr_un addr;
+        std::memset(&addr, 0, sizeof(addr));
+        if (path.empty() || path.size() >= sizeof(addr.sun_path)) {
+            std::cerr << "Error: Invalid stand-in peripheral path: " << path << std::endl;
+            return false;
+        }
+        addr.sun_family = AF_UNIX;
+        std::memcpy(addr.sun_path, path.c_str(), path.size());
+        fd = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if (fd < 0) {
+            std::cerr << "Error: Could not create socket: " << std::strerror(errno) << std::endl;
+            return false;
+        }
+        result = ::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr));
+    } else {
+        SockaddrL2 local;
+        SockaddrL2 remote;
+        std::memset(&local, 0, sizeof(local));
+        std::memset(&remote, 0, sizeof(remote));
+        if (!parseMac(address_, remote.l2_bdaddr)) {
+            std::cerr << "Error: Invalid BLE address: " << address_ << std::endl;
+            return false;
+        }
+        fd = socket(AF_BLUETOOTH_, SOCK_SEQPACKET | SOCK_NONBLOCK | SOCK_CLOEXEC, BTPROTO_L2CAP_);
+        if (fd < 0) {
+            std::cerr << "Error: Could not create L2CAP socket (Bluetooth support, CAP_NET_RAW?): "
+                      << std::strerror(errno) << std::endl;
+            return false;
+        }
+
+        // Any local adapter, LE, fixed ATT channel
+        local.l2_family = AF_BLUETOOTH_;
+        local.l2_cid = toLe16(att::CID);
+        local.l2_bdaddr_type = BDADDR_LE_PUBLIC_;
+        if (bind(fd, reinterpret_cast<sockaddr*>(&local), sizeof(local)) < 0) {
+            std::cerr << "Error: Could not bind L2CAP socket: " << std::strerror(errno) << std::endl;
+            close(fd);
+            return false;
+        }
+        BtSecurity security = {BT_SECURITY_LOW_, 0};
+        setsockopt(fd, SOL_BLUETOOTH_, BT_SECURITY_, &security, sizeof(security));
+
+        remote.l2_family = AF_BLUETOOTH_;
+        remote.l2_cid = toLe16(att::CID);
+        remote.l2_bdaddr_type = random_address_ ? BDADDR_LE_RANDOM_ : BDADDR_LE_PUBLIC_;
+        result = ::connect(fd, reinterpret_cast<sockaddr*>(&remote), sizeof(remote));
+    }
+
+    if (result < 0 && errno != EINPROGRESS && errno != EAGAIN) {
+        std::cerr << "Error: Could not connect to " << address_ << ": " << std::strerror(errno) << std::endl;
+        close(fd);
+        return false;
+    }
+
+    // Keep only a few PDUs in flight (the kernel rounds this up to its minimum)
+    int send_buffer = SEND_BUFFER_PDUS * static_cast<int>(att::DEFAULT_MTU);
+    setsockopt(fd, SOL_SOCKET, SO_SNDBUF, &send_buffer, sizeof(send_buffer));
+
+    pending_fd_ = fd;
+    if (result < 0 && !waitWritable()) {
+        close(pending_fd_);
+        pending_fd_ = -1;
+        return false;
+    }
+    return true;
+}
+
+int AttTransport::pollPending(short events, int timeout_ms) {
+    pollfd pfds[2] = {{pending_fd_, events, 0}, {wake_pipe_[0], POLLIN, 0}};
+    int ready = poll(pfds, 2, timeout_ms);
+    if (aborted_) {
+        return 0;
+    }
+    return ready > 0 && pfds[0].revents == 0 ? 0 : ready;
+}
+
+bool AttTransport::waitWritable() {
+    int ready = pollPending(POLLOUT, timeout_ms_);
+    if (aborted_) {
+        return false;
+    }
+    int error = 0;
+    socklen_t length = sizeof(error);
+    if (ready <= 0 || getsockopt(pending_fd_, SOL_SOCKET, SO_ERROR, &error, &length) < 0 || error != 0) {
+        std::cerr << "Error: Could not connect to " << address_ << ": "
+                  << (ready == 0 ? "timed out" : std::strerror(error ? error : errno)) << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool AttTransport::request(const uint8_t* pdu, size_t size, uint8_t* response, size_t& response_size) {
+    if (send(pending_fd_, pdu, size, MSG_NOSIGNAL) != static_cast<ssize_t>(size)) {
+        std::cerr << "Error: ATT request failed: " << std::strerror(errno) << std::endl;
+        return false;
+    }
+
+    // Wait for the matching response (or an error); anything else the peer sends is skipped
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms_);
+    while (true) {
+        if (pollPending(POLLIN, remainingMs(deadline)) <= 0) {
+            if (!aborted_) {
+                std::cerr << "Error: ATT request timed out" << std::endl;
+            }
+            return false;
+        }
+        ssize_t received = recv(pending_fd_, response, att::MAX_PDU, 0);
+        if (received <= 0) {
+            if (received < 0 && (errno == EAGAIN || errno == EINTR)) {
+                continue;
+            }
+            std::cerr << "Error: ATT link closed during discovery" << std::endl;
+            return false;
+        }
+        if (response[0] == pdu[0] + 1 || (response[0] == att::ERROR_RSP && received >= 5 && response[1] == pdu[0])) {
+            response_size = static_cast<size_t>(received);
+            return true;
+        }
+    }
+}
+
+bool AttTransport::discoverHandle() {
+    uint8_t response[att::MAX_PDU];
+    uint16_t start = 0x0001;
+    while (true) {
+        uint8_t pdu[7];
+        pdu[0] = att::READ_BY_TYPE_REQ;
+        att::putLe16(pdu + 1, start);
+        att::putLe16(pdu + 3, 0xffff);
+        att::putLe16(pdu + 5, att::CHARACTERISTIC_UUID);
+        size_t size = 0;
+        if (!request(pdu, sizeof(pdu), response, size)) {
+            return false;
+        }
+        if (response[0] == att::ERROR_RSP || size < 2) {
+            break;  // Attribute Not Found: every declaration has been listed
+        }
+
+        // Entries: declaration handle, properties, value handle, 16- or 128-bit UUID
+        size_t length = response[1];
+        if (length != 7 && length != 21) {
+            std::cerr << "Error: Malformed Read By Type response" << std::endl;
+            return false;
+        }
+        uint16_t last = start;
+        for (size_t offset = 2; offset + length <= size; offset += length) {
+            const uint8_t* entry = response + offset;
+            last = att::getLe16(entry);
+            att::Uuid uuid = (length == 7) ? att::shortUuid(att::getLe16(entry + 5)) : att::Uuid();
+            if (length == 21) {
+                std::memcpy(uuid.data(), entry + 5, uuid.size());
+            }
+            if (uuid == characteristic_) {
+                if (!(entry[2] & att::PROP_WRITE_NO_RESPONSE)) {
+                    std::cerr << "Error: Characteristic does not support write without response" << std::endl;
+                    return false;
+                }
+                value_handle_ = att::getLe16(entry + 3);
+                return true;
+            }
+        }
+        if (last == 0xffff || last < start) {
+            break;
+        }
+        start = static_cast<uint16_t>(last + 1);
+    }
+    std::cerr << "Error: Characteristic not found on " << address_ << std::endl;
+    return false;
+}
+
+bool AttTransport::connect() {
+    if (isConnected()) {
+        return true;
+    }
+    value_handle_ = 0;
+    if (aborted_ || !openSocket()) {
+        return false;
+    }
+    if (!discoverHandle()) {
+        close(pending_fd_);
+        pending_fd_ = -1;
+        return false;
+    }
+    fd_ = pending_fd_;
+    pending_fd_ = -1;
+    return true;
+}
+
+void AttTransport::disconnect() {
+    int fd = fd_.exchange(-1);
+    if (fd >= 0) {
+        close(fd);
+    }
+}
+
+void AttTransport::abortConnect() {
+    // The flag covers an attempt that has not reached its first poll yet
+    aborted_ = true;
+    if (wake_pipe_[1] >= 0) {
+        char byte = 1;
+        ssize_t written = ::write(wake_pipe_[1], &byte, 1);
+        (void)written;  // A full pipe is readable already
+    }
+}
+
+void AttTransport::resumeConnect() {
+    char buffer[16];
+    while (wake_pipe_[0] >= 0 && read(wake_pipe_[0], buffer, sizeof(buffer)) > 0) {
+    }
+    aborted_ = false;
+}
+
+WriteResult AttTransport::write(const uint8_t* data, size_t size) {
+    int fd = fd_.load();
+    if (fd < 0 || size > att::DEFAULT_MTU - 3) {
+        return WriteResult::FAILED;
+    }
+    uint8_t pdu[att::DEFAULT_MTU];
+    pdu[0] = att::WRITE_CMD;
+    att::putLe16(pdu + 1, value_handle_);
+    std::memcpy(pdu + 3, data, size);
+
+    ssize_t sent = send(fd, pdu, size + 3, MSG_DONTWAIT | MSG_NOSIGNAL);
+    if (sent == static_cast<ssize_t>(size + 3)) {
+        return WriteResult::OK;
+    }
+    if (sent < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == ENOBUFS || errno == EINTR)) {
+        return WriteResult::BUSY;
+    }
+    std::cerr << "Error: BLE link lost: " << std::strerror(errno) << std::endl;
+    disconnect();
+    return WriteResult::FAILED;
+}
+
+} // namespace rc_car
@@ -8,6 +8,8 @@
 #include <algorithm>
 #include <iostream>
 #include <limits>
+#include <sstream>
+#include <filesystem>
 
 #ifndef M_PI
 #define M_PI 3.14159265358979323846
@@ -16,60 +18,425 @@
 namespace rc_car {
 
 BoundaryDetection::BoundaryDetection()
-    : black_threshold_(50), ray_max_length_(200), evasive_threshold_(80) {
+    : black_threshold_(50), ray_max_length_(200), evasive_threshold_(80),
+      batch_rays_(false), mode_(GuidanceMode::RAY_MARCH), field_refresh_frames_(0), frames_since_refresh_(0),
+      field_refresh_requested_(false), histogram_rays_(65), histogram_fov_(180.0), histogram_smoothing_(2),
+      lookahead_(60), wheelbase_(40.0), waypoint_spacing_(5.0f), travel_direction_(1), pursuit_index_(-1), line_retry_frames_(0),
+      policy_cell_size_(8), policy_headings_(72), centreline_from_track_(false),
+      incremental_mask_(false), hierarchical_rays_(false), coherent_rays_(false), verify_rays_(false),
+      ground_view_(false), steering_limit_(30),
+      evasive_target_(false) {
     ray_angles_ = {-60.0, 0.0, 60.0};  // Default: -60°, 0°, +60°
     rays_.resize(3);
+    rebuildHistogramFan();
 }
 
 BoundaryDetection::BoundaryDetection(int black_threshold, int ray_max_length, int evasive_threshold)
     : black_threshold_(black_threshold), ray_max_length_(ray_max_length), 
-      evasive_threshold_(evasive_threshold) {
+      evasive_threshold_(evasive_threshold),
+      batch_rays_(false), mode_(GuidanceMode::RAY_MARCH), field_refresh_frames_(0), frames_since_refresh_(0),
+      field_refresh_requested_(false), histogram_rays_(65), histogram_fov_(180.0), histogram_smoothing_(2),
+      lookahead_(60), wheelbase_(40.0), waypoint_spacing_(5.0f), travel_direction_(1), pursuit_index_(-1), line_retry_frames_(0),
+      policy_cell_size_(8), policy_headings_(72), centreline_from_track_(false),
+      incremental_mask_(false), hierarchical_rays_(false), coherent_rays_(false), verify_rays_(false),
+      ground_view_(false), steering_limit_(30),
+      evasive_target_(false) {
     ray_angles_ = {-60.0, 0.0, 60.0};
     rays_.resize(3);
+    rebuildHistogramFan();
 }
 
-bool BoundaryDetection::isBoundaryPixel(const cv::Vec3b& pixel) const {
-    // Convert to grayscale
-    int gray_value = (static_cast<int>(pixel[0]) + static_cast<int>(pixel[1]) + static_cast<int>(pixel[2])) / 3;
-    return gray_value < black_threshold_;
+void BoundaryDetection::setHistogramFan(int rays, double fov_deg) {
+    histogram_fov_ = std::max(1.0, std::min(360.0, fov_deg));
+    histogram_rays_ = std::max(3, rays);
+    if (!histogramWraps() && histogram_rays_ % 2 == 0) {
+        ++histogram_rays_;  // An even fan has no bin straight ahead and leans to one side
+    }
+    rebuildHistogramFan();
+}
+
+void BoundaryDetection::rebuildHistogramFan() {
+    // Evenly spaced bins from -fov/2 (left) to +fov/2 (right), bin rays/2 at 0°. A full
+    // circle is spaced fov/rays so -180° and +180° are not both in it.
+    const int ahead = histogram_rays_ / 2;
+    double step = histogramWraps() ? histogram_fov_ / histogram_rays_ : histogram_fov_ / (histogram_rays_ - 1);
+    histogram_angles_.resize(histogram_rays_);
+    for (int i = 0; i < histogram_rays_; ++i) {
+        histogram_angles_[i] = (i - ahead) * step;
+    }
 }
 
-int BoundaryDetection::castRay(const Position& start, double angle, const cv::Mat& track_image) {
-    double angle_rad = angle * M_PI / 180.0;
-    double dx = std::cos(angle_rad);
-    double dy = std::sin(angle_rad);
+bool BoundaryDetection::loadTrackImage(const std::string& path) {
+    cv::Mat image = cv::imread(path, cv::IMREAD_COLOR);
+    if (image.empty()) {
+        std::cerr << "Error: Could not load track image: " << path << std::endl;
+        return false;
+    }
     
-    int distance = ray_max_length_;
+    buildBoundaryMask(image, track_mask_);
+    cache_.setSourceImage(image);
+    centreline_.clear();
+    racing_line_.clear();
+    policy_table_.clear();
+    line_retry_frames_ = 0;
+    return true;
+}
+
+std::string BoundaryDetection::centrelineCacheParams() const {
+    std::ostringstream params;
+    params << "black_threshold=" << black_threshold_ << ";spacing=" << waypoint_spacing_
+           << ";seed_radius=" << RAY_START_OFFSET;
+    return params.str();
+}
+
+bool BoundaryDetection::extractCentreline(const cv::Mat& frame, const Position& seed) {
+    cv::Mat mask;
+    bool from_track = !track_mask_.empty() && (frame.empty() || track_mask_.size() == frame.size());
+    if (from_track) {
+        mask = track_mask_;
+    } else if (!frame.empty()) {
+        buildBoundaryMask(frame, mask);
+    }
+    centreline_from_track_ = false;
     
-    // Cast ray from start position
-    for (int i = 20; i < ray_max_length_; ++i) {  // Start at 20 to avoid detecting car itself
-        int x = start.x + static_cast<int>(dx * i);
-        int y = start.y + static_cast<int>(dy * i);
-        
-        // Check bounds
-        if (x < 0 || x >= track_image.cols || y < 0 || y >= track_image.rows) {
-            distance = i;
-            break;
+    // A cached centreline is only reused if the car is actually on it (the seed picks the track region)
+    std::string cache_path = from_track ? cache_.path("centreline", centrelineCacheParams(), ".rcc") : "";
+    if (!cache_path.empty() && std::filesystem::exists(cache_path) && centreline_.load(cache_path)) {
+        cv::Point2f p(static_cast<float>(seed.x), static_cast<float>(seed.y));
+        int nearest = centreline_.nearestWaypoint(p);
+        const cv::Point2f& w = centreline_.waypoints()[nearest];
+        if (std::hypot(w.x - p.x, w.y - p.y) <= centreline_.clearance()[nearest] + centreline_.spacing()) {
+            std::cout << "Track centreline loaded from cache: " << centreline_.size() << " waypoints" << std::endl;
+            centreline_from_track_ = true;
+            return true;
         }
-        
-        // Check pixel color
-        cv::Vec3b pixel = track_image.at<cv::Vec3b>(y, x);
-        if (isBoundaryPixel(pixel)) {
-            distance = i;
-            break;
+    }
+    
+    if (mask.empty() || !centreline_.extract(mask, seed, RAY_START_OFFSET, waypoint_spacing_)) {
+        std::cerr << "Warning: Could not extract track centreline" << std::endl;
+        return false;
+    }
+    std::cout << "Track centreline extracted: " << centreline_.size() << " waypoints ("
+              << (centreline_.isClosed() ? "closed" : "open") << ")" << std::endl;
+    
+    if (!cache_path.empty()) {
+        cache_.store(cache_path, [this](const std::string& path) { return centreline_.save(path); });
+    }
+    centreline_from_track_ = from_track;
+    return true;
+}
+
+bool BoundaryDetection::loadRacingLine(const std::string& path) {
+    if (!racing_line_.load(path)) {
+        return false;
+    }
+    std::cout << "Racing line loaded: " << racing_line_.line().size() << " points from " << path << std::endl;
+    return true;
+}
+
+bool BoundaryDetection::buildRacingLine() {
+    std::string cache_path;
+    if (centreline_from_track_) {
+        // The centreline itself is part of the key: the car's position picks which track region
+        // it follows, and the centreline cache key does not say which
+        const std::vector<cv::Point2f>& waypoints = centreline_.waypoints();
+        uint64_t centreline_hash = TrackCache::hash(waypoints.data(), waypoints.size() * sizeof(cv::Point2f));
+        std::ostringstream params;
+        params << centrelineCacheParams() << ";centreline=" << std::hex << centreline_hash << std::dec
+               << ";iterations=" << racing_params_.iterations
+               << ";margin=" << racing_params_.margin << ";max_speed=" << racing_params_.max_speed
+               << ";min_speed=" << racing_params_.min_speed << ";radius=" << racing_params_.full_speed_radius
+               << ";accel=" << racing_params_.accel << ";brake=" << racing_params_.brake;
+        cache_path = cache_.path("racing_line", params.str(), ".rcl");
+        if (!cache_path.empty() && std::filesystem::exists(cache_path) && loadRacingLine(cache_path)) {
+            return true;
+        }
+    }
+    
+    if (!racing_line_.optimise(centreline_, racing_params_)) {
+        std::cerr << "Warning: Could not optimise racing line" << std::endl;
+        return false;
+    }
+    std::cout << "Racing line optimised: " << racing_line_.line().size() << " points" << std::endl;
+    
+    if (!cache_path.empty()) {
+        cache_.store(cache_path, [this](const std::string& path) { return racing_line_.save(path); });
+    }
+    return true;
+}
+
+void BoundaryDetection::setMaskTiling(int tile_size, int diff_threshold) {
+    tiled_mask_.setTileSize(tile_size);
+    tiled_mask_.setDiffThreshold(diff_threshold);
+    tiled_mask_.invalidate();
+}
+
+bool BoundaryDetection::loadGroundProjection(const std::string& path) {
+    if (!ground_.load(path)) {
+        return false;
+    }
+    std::cout << "Ground projection loaded: " << ground_.size().width << "x" << ground_.size().height
+              << " at " << ground_.unitsPerPixel() << " mm/px" << std::endl;
+    return true;
+}
+
+void BoundaryDetection::setCoherentRays(bool enabled, bool verify) {
+    coherent_rays_ = enabled;
+    verify_rays_ = verify;
+    mask_pyramid_.clear();
+    prev_ray_distances_.clear();
+    ray_stats_ = CoherentRayStats();
+}
+
+void BoundaryDetection::setPolicyGrid(int cell_size, int headings) {
+    policy_cell_size_ = std::max(1, cell_size);
+    policy_headings_ = std::max(1, headings);
+}
+
+bool BoundaryDetection::loadPolicyTable(const std::string& path) {
+    if (!policy_table_.load(path)) {
+        return false;
+    }
+    if (policy_table_.minLength() != RAY_START_OFFSET || policy_table_.maxLength() != ray_max_length_) {
+        std::cerr << "Error: Policy table rays run " << policy_table_.minLength() << ".." << policy_table_.maxLength()
+                  << " px, guidance uses " << RAY_START_OFFSET << ".." << ray_max_length_
+                  << " (boundary.ray_max_length); rebuild the table" << std::endl;
+        policy_table_.clear();
+        return false;
+    }
+    // The table stores angles as floats, so equal angles may differ in the last bits
+    const std::vector<double>& table_angles = policy_table_.rayAngles();
+    bool same_angles = table_angles.size() == ray_angles_.size();
+    for (size_t i = 0; same_angles && i < table_angles.size(); ++i) {
+        double tolerance = ANGLE_TOLERANCE * std::max(1.0, std::abs(ray_angles_[i]));
+        same_angles = std::abs(table_angles[i] - ray_angles_[i]) <= tolerance;
+    }
+    if (!same_angles) {
+        std::cerr << "Warning: Policy table ray angles differ from boundary.ray_angles; using the table's" << std::endl;
+        ray_angles_ = policy_table_.rayAngles();
+    }
+    std::cout << "Policy table mapped: " << path << " (" << policy_table_.coverage().width << "x"
+              << policy_table_.coverage().height << ", " << policy_table_.headings() << " headings)" << std::endl;
+    return true;
+}
+
+bool BoundaryDetection::buildPolicyTable(const cv::Mat& frame, const Position& car_pos) {
+    cv::Mat mask;
+    bool from_track = !track_mask_.empty() && (frame.empty() || track_mask_.size() == frame.size());
+    if (from_track) {
+        mask = track_mask_;
+    } else if (!frame.empty()) {
+        buildBoundaryMask(frame, mask);
+        // The car is dark too; clear it as refreshDistanceField does, or the table keeps it as an obstacle
+        cv::circle(mask, cv::Point(car_pos.x, car_pos.y), RAY_START_OFFSET - 2, cv::Scalar(0), -1);
+    }
+    
+    std::string cache_path;
+    if (from_track) {
+        std::ostringstream params;
+        params << "black_threshold=" << black_threshold_ << ";cell=" << policy_cell_size_
+               << ";headings=" << policy_headings_ << ";min=" << RAY_START_OFFSET << ";max=" << ray_max_length_
+               << ";angles=";
+        for (double angle : ray_angles_) {
+            params << angle << ",";
+        }
+        cache_path = cache_.path("policy", params.str(), ".rpt");
+        if (!cache_path.empty() && std::filesystem::exists(cache_path) && loadPolicyTable(cache_path)) {
+            return true;
+        }
+    }
+    
+    if (mask.empty() || !policy_table_.build(mask, ray_angles_, policy_cell_size_, policy_headings_,
+                                             RAY_START_OFFSET, ray_max_length_)) {
+        std::cerr << "Warning: Could not build policy table" << std::endl;
+        return false;
+    }
+    std::cout << "Policy table built: " << policy_table_.coverage().width << "x" << policy_table_.coverage().height
+              << ", " << policy_headings_ << " headings" << std::endl;
+    
+    if (!cache_path.empty()) {
+        cache_.store(cache_path, [this](const std::string& path) { return policy_table_.save(path); });
+    }
+    return true;
+}
+
+const std::vector<double>& BoundaryDetection::activeRayAngles() const {
+    return (mode_ == GuidanceMode::POLAR_HISTOGRAM) ? histogram_angles_ : ray_angles_;
+}
+
+void BoundaryDetection::buildBoundaryMask(const cv::Mat& frame, cv::Mat& mask) {
+    const cv::Mat* gray = &frame;
+    if (frame.channels() == 3) {
+        cv::cvtColor(frame, gray_frame_, cv::COLOR_BGR2GRAY);
+        gray = &gray_frame_;
+    } else if (frame.channels() == 4) {
+        cv::cvtColor(frame, gray_frame_, cv::COLOR_BGRA2GRAY);
+        gray = &gray_frame_;
+    }
+    
+    // Boundary where gray < black_threshold_
+    cv::threshold(*gray, mask, black_threshold_ - 1, 255, cv::THRESH_BINARY_INV);
+}
+
+void BoundaryDetection::updateMaskTiles(const cv::Mat& frame, const Position& car_pos) {
+    // Keep the car out of the mask: tracker bbox when known, else the area inside the first ray sample
+    cv::Rect exclude = car_bbox_;
+    if (exclude.area() <= 0 || !exclude.contains(cv::Point(car_pos.x, car_pos.y))) {
+        int r = RAY_START_OFFSET - 2;
+        exclude = cv::Rect(car_pos.x - r, car_pos.y - r, 2 * r + 1, 2 * r + 1);
+    }
+    
+    const std::vector<cv::Rect>& dirty = tiled_mask_.update(frame, black_threshold_, exclude);
+    if (mode_ != GuidanceMode::DISTANCE_FIELD || dirty.empty()) {
+        return;
+    }
+    
+    // Re-derive the field over the changed tiles only, unless that would cost more than a rebuild
+    const cv::Mat& mask = tiled_mask_.mask();
+    int grown = tiled_mask_.tileSize() + 4 * INCREMENTAL_FIELD_CAP;
+    bool full = !distance_field_.isValid() || distance_field_.size() != mask.size() ||
+                static_cast<double>(dirty.size()) * grown * grown >= static_cast<double>(mask.total());
+    if (full) {
+        distance_field_.build(mask, INCREMENTAL_FIELD_CAP);
+        frames_since_refresh_ = 0;
+        field_refresh_requested_ = false;
+    } else {
+        for (const auto& tile : dirty) {
+            distance_field_.update(mask, tile, INCREMENTAL_FIELD_CAP);
         }
     }
+}
+
+void BoundaryDetection::buildGroundMask(const cv::Mat& frame, const Position& ground_pos) {
+    // Same window as in the image, on the ground grid: only it is undistorted and warped
+    int reach = std::max(RAY_START_OFFSET, ray_max_length_ - 1);
+    cv::Size grid = ground_.size();
+    cv::Rect window = cv::Rect(ground_pos.x - reach, ground_pos.y - reach, 2 * reach + 1, 2 * reach + 1) &
+                      cv::Rect(0, 0, grid.width, grid.height);
+    mask_origin_ = window.tl();
+    if (window.area() <= 0) {
+        binary_frame_.release();  // Car off the calibrated grid: every sample is a hit
+        return;
+    }
+    ground_.warp(frame, window, ground_frame_);
+    buildBoundaryMask(ground_frame_, binary_frame_);
+    
+    // The car's footprint is larger than RAY_START_OFFSET at most scales; keep it out of the mask
+    if (car_bbox_.area() > 0) {
+        const cv::Point2f corners[4] = {
+            cv::Point2f(car_bbox_.x, car_bbox_.y), cv::Point2f(car_bbox_.br().x, car_bbox_.y),
+            cv::Point2f(car_bbox_.br().x, car_bbox_.br().y), cv::Point2f(car_bbox_.x, car_bbox_.br().y)
+        };
+        std::vector<std::vector<cv::Point>> footprint(1);
+        for (const auto& corner : corners) {
+            cv::Point2f g = ground_.toGround(corner);
+            footprint[0].emplace_back(static_cast<int>(std::lround(g.x)) - window.x,
+                                      static_cast<int>(std::lround(g.y)) - window.y);
+        }
+        cv::fillPoly(binary_frame_, footprint, cv::Scalar(0));
+    }
+}
+
+void BoundaryDetection::refreshDistanceField(const cv::Mat& frame, const Position& car_pos) {
+    cv::Mat mask;
+    buildBoundaryMask(frame, mask);
+    
+    // The car is dark too; clear it so it is not baked into the static field.
+    // Stay inside the first ray sample (truncation can pull it up to sqrt(2) px closer).
+    cv::circle(mask, cv::Point(car_pos.x, car_pos.y), RAY_START_OFFSET - 2, cv::Scalar(0), -1);
     
+    distance_field_.build(mask);
+    frames_since_refresh_ = 0;
+    field_refresh_requested_ = false;
+}
+
+float BoundaryDetection::distanceToNearestWall(const Position& pos) const {
+    if (mode_ != GuidanceMode::DISTANCE_FIELD || !distance_field_.isValid()) {
+        return -1.0f;
+    }
+    return distance_field_.distanceToWall(pos);
+}
+
+int BoundaryDetection::marchRay(const Position& local, const RayDirection& dir) const {
+    if (hierarchical_rays_ && mask_pyramid_.isValid()) {
+        return mask_pyramid_.castRay(local, dir, RAY_START_OFFSET, ray_max_length_);
+    }
+    return MaskRayCaster::castRay(rayMask(), local, dir, RAY_START_OFFSET, ray_max_length_);
+}
+
+int BoundaryDetection::castCoherent(size_t index, const Position& local, const RayDirection& dir,
+                                    double angle, bool stable) {
+    ++ray_stats_.rays;
+    int distance;
+    // After a pose jump last frame's hit says little about this one, so cast from the car
+    if (stable && std::abs(angle - prev_ray_angles_[index]) <= COHERENT_MAX_TURN) {
+        bool closer = false;
+        distance = mask_pyramid_.castRayFrom(local, dir, RAY_START_OFFSET, ray_max_length_,
+                                             prev_ray_distances_[index], &closer);
+        ++ray_stats_.reused;
+        if (closer) {
+            ++ray_stats_.closer;
+        }
+    } else {
+        distance = mask_pyramid_.castRay(local, dir, RAY_START_OFFSET, ray_max_length_);
+        ++ray_stats_.full;
+    }
+    
+    if (verify_rays_) {
+        ++ray_stats_.verified;
+        int plain = MaskRayCaster::castRay(rayMask(), local, dir, RAY_START_OFFSET, ray_max_length_);
+        if (plain != distance) {
+            ++ray_stats_.mismatches;
+            distance = plain;
+        }
+    }
     return distance;
 }
 
 void BoundaryDetection::updateRays(const Position& car_pos, double car_heading) {
+    const std::vector<double>& ray_angles = activeRayAngles();
     rays_.clear();
-    rays_.reserve(ray_angles_.size());
+    rays_.reserve(ray_angles.size());
     
-    for (double relative_angle : ray_angles_) {
-        double absolute_angle = car_heading + relative_angle;
-        int distance = castRay(car_pos, absolute_angle, gray_frame_);
+    bool batch = (mode_ == GuidanceMode::RAY_MARCH && batch_rays_) || mode_ == GuidanceMode::POLAR_HISTOGRAM;
+    bool table = mode_ == GuidanceMode::POLICY_TABLE;
+    bool coherent = coherent_rays_ && mode_ == GuidanceMode::RAY_MARCH && !batch_rays_ && mask_pyramid_.isValid();
+    bool stable = coherent && prev_ray_distances_.size() == ray_angles.size() &&
+                  std::abs(car_pos.x - prev_ray_pos_.x) <= COHERENT_MAX_SHIFT &&
+                  std::abs(car_pos.y - prev_ray_pos_.y) <= COHERENT_MAX_SHIFT;
+    
+    // Mask-based casts run in the coordinates of the mask window
+    Position local(car_pos.x - mask_origin_.x, car_pos.y - mask_origin_.y);
+    if (table) {
+        // Outside the table counts as a hit, like leaving the frame
+        fan_distances_.resize(ray_angles.size());
+        if (!policy_table_.lookup(static_cast<float>(car_pos.x), static_cast<float>(car_pos.y), car_heading,
+                                  fan_distances_.data())) {
+            std::fill(fan_distances_.begin(), fan_distances_.end(), RAY_START_OFFSET);
+        }
+    } else if (batch) {
+        fan_angles_.resize(ray_angles.size());
+        fan_distances_.resize(ray_angles.size());
+        for (size_t i = 0; i < ray_angles.size(); ++i) {
+            fan_angles_[i] = car_heading + ray_angles[i];
+        }
+        BatchRayCaster::castRays(packed_mask_, local, fan_angles_.data(), static_cast<int>(fan_angles_.size()),
+                                 RAY_START_OFFSET, ray_max_length_, fan_distances_.data());
+    }
+    
+    for (size_t i = 0; i < ray_angles.size(); ++i) {
+        double absolute_angle = car_heading + ray_angles[i];
+        RayDirection dir(absolute_angle);
+        int distance;
+        if (batch || table) {
+            distance = fan_distances_[i];
+        } else if (mode_ == GuidanceMode::DISTANCE_FIELD) {
+            distance = distance_field_.castRay(car_pos, dir, RAY_START_OFFSET, ray_max_length_);
+        } else if (coherent) {
+            distance = castCoherent(i, local, dir, absolute_angle, stable);
+        } else {
+            distance = marchRay(local, dir);
+        }
         
         Ray ray;
         ray.start = car_pos;
@@ -77,12 +444,23 @@ void BoundaryDetection::updateRays(const Position& car_pos, double car_heading)
         ray.distance = distance;
         
         // Calculate end position
-        double angle_rad = absolute_angle * M_PI / 180.0;
-        ray.end.x = car_pos.x + static_cast<int>(std::cos(angle_rad) * distance);
-        ray.end.y = car_pos.y + static_cast<int>(std::sin(angle_rad) * distance);
+        ray.end.x = car_pos.x + static_cast<int>(dir.dx * distance);
+        ray.end.y = car_pos.y + static_cast<int>(dir.dy * distance);
         
         rays_.push_back(ray);
     }
+    
+    if (coherent) {
+        prev_ray_pos_ = car_pos;
+        prev_ray_angles_.resize(rays_.size());
+        prev_ray_distances_.resize(rays_.size());
+        for (size_t i = 0; i < rays_.size(); ++i) {
+            prev_ray_angles_[i] = rays_[i].angle;
+            prev_ray_distances_[i] = rays_[i].distance;
+        }
+    } else {
+        prev_ray_distances_.clear();
+    }
 }
 
 ControlVector BoundaryDetection::process(const cv::Mat& frame, const Position& car_position,
@@ -103,20 +481,136 @@ ControlVector BoundaryDetection::process(const cv::Mat& frame, const Position& c
     // Clamp base speed to valid range
     base_speed = std::max(0, std::min(255, base_speed));
     
-    // Convert to grayscale
-    if (frame.channels() == 3) {
-        cv::cvtColor(frame, gray_frame_, cv::COLOR_BGR2GRAY);
-        cv::cvtColor(gray_frame_, gray_frame_, cv::COLOR_GRAY2BGR);  // Keep 3 channels for pixel access
-    } else {
-        frame.copyTo(gray_frame_);
+    if (mode_ == GuidanceMode::PURE_PURSUIT || mode_ == GuidanceMode::RACING_LINE) {
+        // The line is prepared once; after that no image work is done per frame
+        bool racing = mode_ == GuidanceMode::RACING_LINE;
+        if (racing ? !racing_line_.isValid() : !centreline_.isValid()) {
+            // Thinning the whole mask is too slow to repeat every frame while it keeps failing
+            if (line_retry_frames_ > 0) {
+                --line_retry_frames_;
+                return ControlVector(0, 0, 0, 0);
+            }
+            if ((!centreline_.isValid() && !extractCentreline(frame, car_position)) ||
+                (racing && !buildRacingLine())) {
+                std::cerr << "Warning: No line to follow, car stopped; retrying in " << LINE_RETRY_FRAMES << " frames" << std::endl;
+                line_retry_frames_ = LINE_RETRY_FRAMES;
+                return ControlVector(0, 0, 0, 0);
+            }
+        }
+        
+        ControlVector control = pursuitGuidance(racing ? racing_line_.line() : centreline_,
+                                                car_position, movement, base_speed);
+        if (racing) {
+            control.speed = racing_line_.speedAt(pursuit_index_);
+        }
+        control.left_turn = std::min(control.left_turn, steering_limit_);
+        control.right_turn = std::min(control.right_turn, steering_limit_);
+        return control;
     }
     
     // Calculate car heading from movement vector
     double car_heading = movement.angle();
+    double car_speed = movement.magnitude();  // Pixels per frame, for the steering model
+    Position ray_origin = car_position;  // Position on the ground grid in bird's-eye guidance
+    ground_view_ = false;
+    
+    if (mode_ == GuidanceMode::DISTANCE_FIELD) {
+        // Static track: only rebuild the field when asked to, periodically, or on resolution change
+        bool refresh_due = field_refresh_frames_ > 0 && ++frames_since_refresh_ >= field_refresh_frames_;
+        bool rebuild = !distance_field_.isValid() || distance_field_.size() != frame.size() ||
+                       field_refresh_requested_ || refresh_due;
+        if (incremental_mask_) {
+            // Changed tiles are folded in every frame; a rebuild re-thresholds everything
+            if (rebuild) {
+                tiled_mask_.invalidate();
+            }
+            updateMaskTiles(frame, car_position);
+        } else if (rebuild) {
+            refreshDistanceField(frame, car_position);
+        }
+        mask_origin_ = cv::Point(0, 0);
+    } else if (mode_ == GuidanceMode::POLICY_TABLE) {
+        // Built once for a static track; per frame only a table lookup remains
+        if (!policy_table_.isValid() && !buildPolicyTable(frame, car_position)) {
+            return ControlVector(0, 0, 0, 0);
+        }
+    } else {
+        ground_view_ = ground_.isValid() && frame.size() == ground_.frameSize();
+        if (ground_view_) {
+            cv::Point2f car = ground_.toGround(cv::Point2f(car_position.x, car_position.y));
+            cv::Point2f ahead = ground_.toGround(cv::Point2f(car_position.x + movement.dx, car_position.y + movement.dy));
+            ray_origin = Position(static_cast<int>(std::lround(car.x)), static_cast<int>(std::lround(car.y)));
+            if (movement.dx != 0 || movement.dy != 0) {
+                car_heading = std::atan2(ahead.y - car.y, ahead.x - car.x) * 180.0 / M_PI;
+            }
+            car_speed = std::hypot(ahead.x - car.x, ahead.y - car.y);
+            buildGroundMask(frame, ray_origin);
+        } else if (incremental_mask_) {
+            updateMaskTiles(frame, car_position);
+            mask_origin_ = cv::Point(0, 0);
+        } else {
+            // Every ray sample lies within ray_max_length_ - 1 px of the car on both axes, so a
+            // window that size (clipped to the frame) gives the same hits as the whole frame
+            int reach = std::max(RAY_START_OFFSET, ray_max_length_ - 1);
+            cv::Rect window = cv::Rect(car_position.x - reach, car_position.y - reach, 2 * reach + 1, 2 * reach + 1) &
+                              cv::Rect(0, 0, frame.cols, frame.rows);
+            buildBoundaryMask(frame(window), binary_frame_);
+            mask_origin_ = window.tl();
+        }
+        if (batch_rays_ || mode_ == GuidanceMode::POLAR_HISTOGRAM) {
+            packed_mask_.pack(rayMask());
+        } else if (hierarchical_rays_ || coherent_rays_) {
+            mask_pyramid_.build(rayMask());
+        }
+    }
     
     // Update rays
-    updateRays(car_position, car_heading);
+    updateRays(ray_origin, car_heading);
+    if (ground_view_) {
+        // Rays were cast on the ground grid; draw them in the camera frame
+        for (auto& ray : rays_) {
+            cv::Point2f end = ground_.toImage(cv::Point2f(ray.end.x, ray.end.y));
+            ray.start = car_position;
+            ray.end = Position(static_cast<int>(std::lround(end.x)), static_cast<int>(std::lround(end.y)));
+        }
+    }
+    
+    ControlVector control = (mode_ == GuidanceMode::POLAR_HISTOGRAM)
+        ? histogramGuidance(car_speed, base_speed)
+        : rayGuidance(car_heading, car_speed, base_speed);
     
+    // Limit steering values
+    control.left_turn = std::min(control.left_turn, steering_limit_);
+    control.right_turn = std::min(control.right_turn, steering_limit_);
+    
+    return control;
+}
+
+double BoundaryDetection::crossTrackError() const {
+    // Half the difference of the sideways clearance seen by the outermost left and right rays:
+    // how far (px) the middle of the free space lies to the right of the car
+    const std::vector<double>& angles = activeRayAngles();
+    if (rays_.size() != angles.size() || rays_.empty()) {
+        return 0.0;
+    }
+    size_t leftmost = std::min_element(angles.begin(), angles.end()) - angles.begin();
+    size_t rightmost = std::max_element(angles.begin(), angles.end()) - angles.begin();
+    double left = angles[leftmost] < 0 ? rays_[leftmost].distance * std::sin(-angles[leftmost] * M_PI / 180.0) : 0.0;
+    double right = angles[rightmost] > 0 ? rays_[rightmost].distance * std::sin(angles[rightmost] * M_PI / 180.0) : 0.0;
+    if (left == 0.0 || right == 0.0) {
+        return 0.0;  // One-sided fan: no balance to keep
+    }
+    return 0.5 * (right - left);
+}
+
+void BoundaryDetection::setSteering(ControlVector& control, double turn) const {
+    // Controller output is a fraction of full lock, positive to the right
+    int steering = static_cast<int>(std::lround(std::min(1.0, std::abs(turn)) * steering_limit_));
+    control.right_turn = turn > 0 ? steering : 0;
+    control.left_turn = turn < 0 ? steering : 0;
+}
+
+ControlVector BoundaryDetection::rayGuidance(double car_heading, double car_speed, int base_speed) {
     // Find minimum and maximum ray distances
     int min_distance = ray_max_length_;
     int max_distance = 0;
@@ -137,21 +631,42 @@ ControlVector BoundaryDetection::process(const cv::Mat& frame, const Position& c
     control.light_on = 1;  // Lights on during autonomous mode
     control.speed = base_speed;
     
-    // Evasive action if too close to boundary
-    if (min_distance < evasive_threshold_) {
-        // Steer toward the direction with maximum clearance
-        int max_ray_index = max_index;
+    if (steering_.getMode() != SteeringMode::BANG_BANG && !rays_.empty()) {
+        // Continuous: head for the clearance-weighted mean ray direction, or the most open ray
+        // when a boundary is inside the evasive threshold; the controller smooths the switch
+        double target = ray_angles_[max_index];
+        bool evasive = min_distance < evasive_threshold_;
+        if (evasive != evasive_target_) {
+            steering_.retarget();  // The target jumps between the two sources
+            evasive_target_ = evasive;
+        }
+        if (!evasive) {
+            double sum = 0.0;
+            double weight_sum = 0.0;
+            for (size_t i = 0; i < rays_.size(); ++i) {
+                double weight = static_cast<double>(rays_[i].distance) * rays_[i].distance;
+                sum += weight * ray_angles_[i];
+                weight_sum += weight;
+            }
+            target = weight_sum > 0.0 ? sum / weight_sum : 0.0;
+        }
+        setSteering(control, steering_.update(target, crossTrackError(), car_speed));
+    } else if (min_distance < evasive_threshold_ && !rays_.empty()) {
+        // Evasive action if too close to boundary
+        // Steer toward the direction with maximum clearance (negative relative angles are to the left)
+        double max_ray_angle = ray_angles_[max_index];
         
-        // Determine steering direction based on which ray has max distance
-        if (max_ray_index == 0) {  // Left ray (-60°)
+        if (max_ray_angle < 0) {
             control.left_turn = 255;
             control.right_turn = 0;
-        } else if (max_ray_index == 2) {  // Right ray (+60°)
+        } else if (max_ray_angle > 0) {
             control.left_turn = 0;
             control.right_turn = 255;
-        } else {  // Center ray (0°)
-            // Choose based on left vs right clearance
-            if (rays_[0].distance > rays_[2].distance) {
+        } else {  // Straight ahead
+            // Choose based on the outermost left vs right clearance
+            auto leftmost = std::min_element(ray_angles_.begin(), ray_angles_.end()) - ray_angles_.begin();
+            auto rightmost = std::max_element(ray_angles_.begin(), ray_angles_.end()) - ray_angles_.begin();
+            if (rays_[leftmost].distance > rays_[rightmost].distance) {
                 control.left_turn = 128;
                 control.right_turn = 0;
             } else {
@@ -178,14 +693,172 @@ ControlVector BoundaryDetection::process(const cv::Mat& frame, const Position& c
         }
     }
     
-    // Limit steering values (as per prototype: max 30)
-    control.left_turn = std::min(control.left_turn, 30);
-    control.right_turn = std::min(control.right_turn, 30);
+    return control;
+}
+
+ControlVector BoundaryDetection::histogramGuidance(double car_speed, int base_speed) {
+    const int bins = static_cast<int>(rays_.size());
+    const bool wraps = histogramWraps();
+    
+    // Smooth the raw clearance with a triangular window, as in VFH (around the seam on a full circle)
+    histogram_.assign(bins, 0.0f);
+    for (int k = 0; k < bins; ++k) {
+        float sum = 0.0f;
+        float weight_sum = 0.0f;
+        for (int j = -histogram_smoothing_; j <= histogram_smoothing_; ++j) {
+            int bin = k + j;
+            if (wraps) {
+                bin = ((bin % bins) + bins) % bins;
+            } else if (bin < 0 || bin >= bins) {
+                continue;
+            }
+            float weight = static_cast<float>(histogram_smoothing_ + 1 - std::abs(j));
+            sum += weight * rays_[bin].distance;
+            weight_sum += weight;
+        }
+        histogram_[k] = sum / weight_sum;
+    }
+    
+    // Bin pointing straight ahead (rebuildHistogramFan puts one at 0°)
+    const int ahead = bins / 2;
+    auto offAhead = [bins, wraps, ahead](int bin) {
+        int d = std::abs(bin - ahead);
+        return wraps ? std::min(d, bins - d) : d;
+    };
+    
+    // On a full circle the scan starts just after a blocked bin, so a sector across the
+    // back seam is seen whole; positions below count from there
+    int first = 0;
+    if (wraps) {
+        for (int bin = 0; bin < bins; ++bin) {
+            if (histogram_[bin] < evasive_threshold_) {
+                first = (bin + 1) % bins;
+                break;
+            }
+        }
+    }
+    auto binAt = [bins, first](int position) { return (position + first) % bins; };
+    const int ahead_position = (ahead - first + bins) % bins;
+    
+    // Free sectors are runs of bins with clearance above the evasive threshold. In each sector
+    // take the bin closest to the heading, kept away from the sector edges where it is wide enough.
+    int target = -1;
+    for (int start = 0; start < bins;) {
+        if (histogram_[binAt(start)] < evasive_threshold_) {
+            ++start;
+            continue;
+        }
+        int end = start;
+        while (end + 1 < bins && histogram_[binAt(end + 1)] >= evasive_threshold_) {
+            ++end;
+        }
+        
+        int margin = std::min(histogram_smoothing_, (end - start) / 2);
+        int low = start + margin;
+        int high = end - margin;
+        int candidate;
+        if (ahead_position >= low && ahead_position <= high) {
+            candidate = ahead;
+        } else {
+            candidate = offAhead(binAt(low)) <= offAhead(binAt(high)) ? binAt(low) : binAt(high);
+        }
+        if (target < 0 || offAhead(candidate) < offAhead(target) ||
+            (offAhead(candidate) == offAhead(target) && histogram_[candidate] > histogram_[target])) {
+            target = candidate;
+        }
+        start = end + 1;
+    }
+    
+    // Nothing is free: head for the most open direction
+    if (target < 0) {
+        target = static_cast<int>(std::max_element(histogram_.begin(), histogram_.end()) - histogram_.begin());
+    }
+    
+    ControlVector control;
+    control.light_on = 1;
     
+    // Steering proportional to the sector offset (positive relative angles are to the right)
+    double target_angle = histogram_angles_[target];
+    double turn;
+    if (steering_.getMode() != SteeringMode::BANG_BANG) {
+        double output = steering_.update(target_angle, crossTrackError(), car_speed);
+        setSteering(control, output);
+        turn = std::abs(output);
+    } else {
+        turn = std::min(1.0, std::abs(target_angle) / FULL_LOCK_ANGLE);
+        setSteering(control, target_angle > 0 ? turn : -turn);
+    }
+    
+    // Slow down when the way ahead is short or the turn is sharp
+    double ahead_factor = std::max(MIN_SPEED_FACTOR, std::min(1.0, histogram_[ahead] / static_cast<double>(ray_max_length_)));
+    double turn_factor = 1.0 - 0.5 * turn;
+    control.speed = static_cast<int>(std::lround(base_speed * ahead_factor * turn_factor));
+    
+    return control;
+}
+
+ControlVector BoundaryDetection::pursuitGuidance(const TrackCentreline& line, const Position& car_pos,
+                                                 const MovementVector& movement, int base_speed) {
+    cv::Point2f car(static_cast<float>(car_pos.x), static_cast<float>(car_pos.y));
+    int nearest = line.nearestWaypoint(car);
+    cv::Point2f tangent = line.tangent(nearest);
+    pursuit_index_ = nearest;
+    
+    // Follow the line in whichever direction the car is moving
+    double car_heading;
+    if (movement.dx != 0 || movement.dy != 0) {
+        travel_direction_ = (tangent.x * movement.dx + tangent.y * movement.dy) >= 0 ? 1 : -1;
+        car_heading = movement.angle();
+    } else {
+        car_heading = std::atan2(travel_direction_ * tangent.y, travel_direction_ * tangent.x) * 180.0 / M_PI;
+    }
+    
+    int steps = std::max(1, static_cast<int>(std::lround(lookahead_ / line.spacing())));
+    const cv::Point2f& goal = line.waypoints()[line.advance(nearest, steps, travel_direction_)];
+    lookahead_point_ = Position(static_cast<int>(std::lround(goal.x)), static_cast<int>(std::lround(goal.y)));
+    
+    // Angle between heading and the lookahead point, normalised to [-180, 180)
+    double goal_angle = std::atan2(goal.y - car.y, goal.x - car.x) * 180.0 / M_PI;
+    double alpha = std::fmod(goal_angle - car_heading + 540.0, 360.0) - 180.0;
+    double distance = std::max(1.0, static_cast<double>(std::hypot(goal.x - car.x, goal.y - car.y)));
+    
+    // Pure pursuit: steering angle = atan(2 L sin(alpha) / Ld)
+    double steer_angle = std::atan2(2.0 * wheelbase_ * std::sin(alpha * M_PI / 180.0), distance) * 180.0 / M_PI;
+    int steering = static_cast<int>(std::lround(std::min(1.0, std::abs(steer_angle) / FULL_LOCK_ANGLE) * steering_limit_));
+    
+    // Single ray to the lookahead point for visualisation
+    rays_.clear();
+    Ray ray;
+    ray.start = car_pos;
+    ray.end = lookahead_point_;
+    ray.angle = goal_angle;
+    ray.distance = static_cast<int>(distance);
+    rays_.push_back(ray);
+    
+    ControlVector control;
+    control.light_on = 1;
+    control.speed = base_speed;
+    control.right_turn = steer_angle > 0 ? steering : 0;
+    control.left_turn = steer_angle < 0 ? steering : 0;
     return control;
 }
 
 void BoundaryDetection::drawRays(cv::Mat& frame, const Position& car_pos) const {
+    const TrackCentreline* path = nullptr;
+    if (mode_ == GuidanceMode::PURE_PURSUIT && centreline_.isValid()) {
+        path = &centreline_;
+    } else if (mode_ == GuidanceMode::RACING_LINE && racing_line_.isValid()) {
+        path = &racing_line_.line();
+    }
+    if (path) {
+        std::vector<cv::Point> line;
+        line.reserve(path->size());
+        for (const auto& w : path->waypoints()) {
+            line.emplace_back(static_cast<int>(w.x), static_cast<int>(w.y));
+        }
+        cv::polylines(frame, line, path->isClosed(), cv::Scalar(0, 200, 0), 1);
+    }
+    
     for (const auto& ray : rays_) {
         cv::line(frame, 
                 cv::Point(ray.start.x, ray.start.y),
@@ -0,0 +1,135 @@
+/**
+ * @file command_shaper.cpp
+ * @brief Interpolation/extrapolation and rate/jerk limiting of guidance outputs at the send rate
+ */
+
+#include "command_shaper.h"
+#include <algorithm>
+#include <cmath>
+
+namespace rc_car {
+
+namespace {
+
+constexpr double CHANNEL_LIMIT = 127.0;  // Larger byte values encode the opposite direction
+
+int roundToCommand(double value) {
+    return static_cast<int>(std::lround(std::max(-CHANNEL_LIMIT, std::min(CHANNEL_LIMIT, value))));
+}
+
+} // namespace
+
+CommandShaper::CommandShaper()
+    : speed_(), steering_(), light_(0), has_sample_(false), has_slope_(false), has_output_(false),
+      interval_s_(INITIAL_INTERVAL_S), slope_dt_s_(INITIAL_INTERVAL_S) {
+}
+
+double CommandShaper::signedSpeed(const ControlVector& control) {
+    // Reverse is sent as 255 - speed (BLEHandler::setReverseSpeed)
+    return control.speed <= MAX_FORWARD_SPEED ? control.speed : control.speed - 255;
+}
+
+double CommandShaper::signedSteering(const ControlVector& control) {
+    return control.right_turn > 0 ? control.right_turn : -control.left_turn;
+}
+
+void CommandShaper::reset(const ControlVector& current) {
+    double speed = signedSpeed(current);
+    double steering = signedSteering(current);
+    speed_ = Channel{speed, speed, speed, speed, 0.0};
+    steering_ = Channel{steering, steering, steering, steering, 0.0};
+    light_ = current.light_on;
+    has_sample_ = false;
+    has_slope_ = false;
+    has_output_ = false;
+}
+
+void CommandShaper::update(const ControlVector& target, std::chrono::steady_clock::time_point time) {
+    double since_s = 0.0;
+    if (has_sample_) {
+        since_s = std::max(0.0, std::chrono::duration<double>(time - sample_time_).count());
+        has_slope_ = since_s > 0.0 && since_s <= MAX_INTERVAL_S;
+        if (has_slope_) {
+            interval_s_ += INTERVAL_SMOOTHING * (since_s - interval_s_);
+            slope_dt_s_ = since_s;
+        }
+    }
+
+    // Ramps start where the reference is now, so it stays continuous across samples
+    Channel* channels[] = {&speed_, &steering_};
+    double values[] = {signedSpeed(target), signedSteering(target)};
+    for (int i = 0; i < 2; ++i) {
+        Channel& channel = *channels[i];
+        channel.ramp_from = has_sample_ ? reference(channel, since_s) : channel.output;
+        channel.previous = has_sample_ ? channel.sample : values[i];
+        channel.sample = values[i];
+    }
+    light_ = target.light_on;
+    sample_time_ = time;
+    has_sample_ = true;
+}
+
+double CommandShaper::reference(const Channel& channel, double since_sample_s) const {
+    switch (params_.mode) {
+    case ShapingMode::INTERPOLATE: {
+        double progress = std::min(1.0, since_sample_s / interval_s_);
+        return channel.ramp_from + (channel.sample - channel.ramp_from) * progress;
+    }
+    case ShapingMode::EXTRAPOLATE: {
+        if (!has_slope_) {
+            return channel.sample;
+        }
+        double slope = (channel.sample - channel.previous) / slope_dt_s_;
+        double ahead = std::min(since_sample_s, std::max(0.0, params_.horizon) * interval_s_);
+        return std::max(-CHANNEL_LIMIT, std::min(CHANNEL_LIMIT, channel.sample + slope * ahead));
+    }
+    case ShapingMode::OFF:
+    default:
+        return channel.sample;
+    }
+}
+
+void CommandShaper::limit(Channel& channel, double reference, const ChannelLimits& limits, double dt) {
+    if (limits.rate <= 0.0 && limits.jerk <= 0.0) {
+        channel.output = reference;
+        channel.rate = 0.0;
+        return;
+    }
+    if (dt <= 0.0) {
+        return;
+    }
+
+    double error = reference - channel.output;
+    double rate = error / dt;
+    if (limits.jerk > 0.0) {
+        // No faster than the output can still stop at the reference, and no sudden change of rate
+        double braking = std::sqrt(2.0 * limits.jerk * std::abs(error));
+        rate = std::max(-braking, std::min(braking, rate));
+        rate = std::max(channel.rate - limits.jerk * dt, std::min(channel.rate + limits.jerk * dt, rate));
+    }
+    if (limits.rate > 0.0) {
+        rate = std::max(-limits.rate, std::min(limits.rate, rate));
+    }
+    channel.output += rate * dt;
+    channel.rate = rate;
+}
+
+ControlVector CommandShaper::shape(std::chrono::steady_clock::time_point now) {
+    if (has_sample_) {
+        double dt = has_output_ ? std::chrono::duration<double>(now - output_time_).count() : 0.0;
+        dt = std::max(0.0, std::min(MAX_INTERVAL_S, dt));
+        double since_s = std::max(0.0, std::chrono::duration<double>(now - sample_time_).count());
+
+        limit(speed_, reference(speed_, since_s), params_.speed, dt);
+        limit(steering_, reference(steering_, since_s), params_.steering, dt);
+    }
+    output_time_ = now;
+    has_output_ = true;
+
+    int speed = roundToCommand(speed_.output);
+    int steering = roundToCommand(steering_.output);
+    return ControlVector(light_, speed >= 0 ? speed : 255 + speed,
+                         steering > 0 ? steering : 0, steering < 0 ? -steering : 0);
+}
+
+} // namespace rc_car
@@ -33,6 +33,34 @@ void ConfigManager::loadDefaults() {
     config_["boundary.evasive_threshold"] = "80";
     config_["boundary.ray_angles"] = "-60,0,60";  // Comma-separated
     config_["boundary.base_speed"] = "10";
+    config_["boundary.mode"] = "ray_march";  // ray_march, distance_field, polar_histogram, pure_pursuit, racing_line, policy_table
+    config_["boundary.field_refresh_frames"] = "0";  // 0 = build once, refresh on demand
+    config_["boundary.incremental_mask"] = "false";  // Re-threshold only tiles that changed
+    config_["boundary.mask_tile_size"] = "64";  // Pixels per mask tile
+    config_["boundary.mask_diff_threshold"] = "12";  // Gray levels before a tile counts as changed
+    config_["boundary.batch_rays"] = "false";  // SIMD batch casting for dense ray fans
+    config_["boundary.hierarchical_rays"] = "false";  // Skip free blocks of a mask pyramid (long rays)
+    config_["boundary.coherent_rays"] = "false";  // Start each ray from last frame's hit (ray_march, unbatched)
+    config_["boundary.verify_rays"] = "false";  // Count coherent rays that differ from a plain cast
+    config_["boundary.histogram_rays"] = "65";  // polar_histogram fan size (odd below 360°: one bin straight ahead)
+    config_["boundary.histogram_fov"] = "180";  // Degrees, centred on heading
+    config_["boundary.histogram_smoothing"] = "2";  // Smoothing half-width in bins
+    config_["boundary.track_image"] = "";  // pure_pursuit centreline source (empty = first frame)
+    config_["boundary.cache_dir"] = "cache";  // Derived track artefacts (empty = no cache)
+    config_["boundary.lookahead"] = "60";  // Pixels along the centreline
+    config_["boundary.wheelbase"] = "40";  // Pixels
+    config_["boundary.waypoint_spacing"] = "5";  // Pixels between centreline waypoints
+    config_["boundary.racing_line"] = "";  // Racing line table (empty = optimise on first frame)
+    config_["boundary.racing_margin"] = "10";  // Pixels kept clear of the boundary
+    config_["boundary.racing_max_speed"] = "40";  // Speed on straights
+    config_["boundary.racing_min_speed"] = "10";  // Speed floor in tight corners
+    config_["boundary.racing_full_speed_radius"] = "300";  // Pixels; tighter corners are slowed
+    config_["boundary.racing_accel"] = "2";  // Speed^2 per pixel
+    config_["boundary.racing_brake"] = "4";  // Speed^2 per pixel
+    config_["boundary.policy_table"] = "";  // Policy table file (empty = cast on first frame)
+    config_["boundary.policy_cell_size"] = "8";  // Pixels per policy grid cell
+    config_["boundary.policy_headings"] = "72";  // Heading bins (5 degrees each)
+    config_["boundary.ground_map"] = "";  // Bird's-eye remap table (empty = guide in image pixels)
     
     // BLE settings
     config_["ble.device_mac"] = "f9:af:3c:e2:d2:f5";
@@ -40,12 +68,49 @@ void ConfigManager::loadDefaults() {
     config_["ble.device_identifier"] = "bf0a00082800";
     config_["ble.command_rate_hz"] = "200";
     config_["ble.connection_timeout"] = "5";
-    config_["ble.reconnection_attempts"] = "3";
+    config_["ble.address_type"] = "random";  // LE address type of the car (random|public)
+    config_["ble.mock_latency_ms"] = "0";  // Link impairments when ble.device_mac is "mock:"
+    config_["ble.mock_jitter_ms"] = "0";
+    config_["ble.mock_loss"] = "0";
+    config_["ble.mock_seed"] = "1";
+    config_["ble.send_policy"] = "fixed_rate";  // fixed_rate or on_change
+    config_["ble.keepalive_ms"] = "100";  // on_change: resend an unchanged command this often
+    config_["ble.coalesce_ms"] = "7.5";  // on_change: min spacing of change sends (connection interval, 0 = off)
+    config_["ble.stop_burst"] = "5";  // Stop packets repeated on an emergency stop
+    config_["ble.stop_burst_interval_ms"] = "7.5";  // Spacing of the burst (one per connection interval)
+    config_["ble.reconnection_attempts"] = "0";  // Consecutive failed connects before giving up (0 = never)
+    config_["ble.reconnect_backoff_ms"] = "250";  // First retry delay, doubled per failure
+    config_["ble.reconnect_backoff_max_ms"] = "5000";  // Retry delay cap
+    config_["ble.shaping"] = "off";  // off, interpolate or extrapolate between guidance outputs (fixed_rate only)
+    config_["ble.shaping_horizon"] = "1.0";  // extrapolate: guidance intervals to run ahead before holding
+    config_["ble.speed_rate_limit"] = "0";  // Speed units per second (0 = unlimited)
+    config_["ble.speed_jerk_limit"] = "0";  // Speed units per second squared (0 = unlimited)
+    config_["ble.steering_rate_limit"] = "0";  // Steering units per second, e.g. 600 (0 = unlimited)
+    config_["ble.steering_jerk_limit"] = "0";  // Steering units per second squared, e.g. 20000 (0 = unlimited)
+    config_["ble.checksum"] = "false";  // 8-bit sum in the last byte, only for firmware that checks it (false = 0x00 as the prototype)
     
     // Control settings
     config_["control.speed_limit_forward"] = "100";
     config_["control.speed_limit_reverse"] = "100";
     config_["control.steering_limit"] = "30";
+    config_["control.steering_mode"] = "bang_bang";  // bang_bang, pid or mpc
+    config_["control.pid_kp"] = "0.02";  // Full-lock fractions per degree of error
+    config_["control.pid_ki"] = "0.0005";
+    config_["control.pid_kd"] = "0.01";
+    config_["control.cross_track_gain"] = "0.2";  // Degrees of error per pixel off the middle of the free space
+    config_["control.full_lock_angle"] = "60";  // Wheel angle (deg) at full steering, for the MPC car model
+    config_["control.mpc_horizon"] = "10";  // Guidance cycles predicted
+    config_["control.mpc_budget_us"] = "500";  // Hard solver budget per cycle
+    config_["control.mpc_effort_weight"] = "20";
+    config_["control.mpc_rate_weight"] = "2000";  // Penalises steering changes between cycles
+    config_["control.speed_mode"] = "open_loop";  // open_loop or closed_loop (regulate the tracked velocity)
+    config_["control.speed_kp"] = "0.5";  // Command units per command-unit-equivalent of velocity error
+    config_["control.speed_ki"] = "1.0";  // Per second
+    config_["control.speed_target_scale"] = "0";  // Velocity per speed unit (0 = as measured during warm-up)
+    config_["control.speed_warmup_s"] = "10";  // Open-loop driving to learn the command -> velocity map
+    config_["control.speed_warmup_command"] = "0";  // Warm-up command centre (0 = boundary.base_speed)
+    config_["control.speed_warmup_dither"] = "5";  // +/- speed units alternated during warm-up
+    config_["control.speed_filter_s"] = "0.2";  // Velocity low-pass time constant
     config_["control.light_on_value"] = "0200";
     config_["control.light_off_value"] = "0000";
     
@@ -11,7 +11,7 @@ namespace rc_car {
 ControlOrchestrator::ControlOrchestrator()
     : running_(false), tracking_enabled_(false), guidance_enabled_(false),
       autonomous_mode_(false), tracker_type_(TrackerType::CSRT), base_speed_(10),
-      show_ui_(true) {
+      max_forward_speed_(254), show_ui_(true) {
 }
 
 ControlOrchestrator::~ControlOrchestrator() {
@@ -72,6 +72,110 @@ bool ControlOrchestrator::initialize(const std::string& config_file) {
         guidance_->setRayAngles(ray_angles);
     }
     
+    std::string guidance_mode_str = config_->getString("boundary.mode", "ray_march");
+    if (guidance_mode_str == "distance_field") {
+        guidance_->setMode(GuidanceMode::DISTANCE_FIELD);
+    } else if (guidance_mode_str == "polar_histogram") {
+        guidance_->setMode(GuidanceMode::POLAR_HISTOGRAM);
+    } else if (guidance_mode_str == "pure_pursuit") {
+        guidance_->setMode(GuidanceMode::PURE_PURSUIT);
+    } else if (guidance_mode_str == "racing_line") {
+        guidance_->setMode(GuidanceMode::RACING_LINE);
+    } else if (guidance_mode_str == "policy_table") {
+        guidance_->setMode(GuidanceMode::POLICY_TABLE);
+    } else {
+        guidance_->setMode(GuidanceMode::RAY_MARCH);
+    }
+    guidance_->setFieldRefreshFrames(config_->getInt("boundary.field_refresh_frames", 0));
+    guidance_->setIncrementalMask(config_->getBool("boundary.incremental_mask", false));
+    guidance_->setMaskTiling(config_->getInt("boundary.mask_tile_size", 64),
+                             config_->getInt("boundary.mask_diff_threshold", 12));
+    guidance_->setBatchRays(config_->getBool("boundary.batch_rays", false));
+    guidance_->setHierarchicalRays(config_->getBool("boundary.hierarchical_rays", false));
+    guidance_->setCoherentRays(config_->getBool("boundary.coherent_rays", false),
+                               config_->getBool("boundary.verify_rays", false));
+    guidance_->setHistogramFan(config_->getInt("boundary.histogram_rays", 65),
+                               config_->getDouble("boundary.histogram_fov", 180.0));
+    guidance_->setHistogramSmoothing(config_->getInt("boundary.histogram_smoothing", 2));
+    guidance_->setLookahead(config_->getInt("boundary.lookahead", 60));
+    guidance_->setWheelbase(config_->getDouble("boundary.wheelbase", 40.0));
+    guidance_->setWaypointSpacing(static_cast<float>(config_->getDouble("boundary.waypoint_spacing", 5.0)));
+    
+    // Derived track artefacts are cached by image hash so restarts skip the expensive preprocessing
+    guidance_->setCacheDirectory(config_->getString("boundary.cache_dir", "cache"));
+    
+    // Optional track image for centreline extraction (otherwise the first frame is used)
+    std::string track_image = config_->getString("boundary.track_image", "");
+    if (!track_image.empty()) {
+        guidance_->loadTrackImage(track_image);
+    }
+    
+    // Racing line: table from tools/track_preprocess, otherwise optimised from the centreline on the first frame
+    RacingLineParams racing_params;
+    racing_params.margin = static_cast<float>(config_->getDouble("boundary.racing_margin", 10.0));
+    racing_params.max_speed = static_cast<float>(config_->getDouble("boundary.racing_max_speed", 40.0));
+    racing_params.min_speed = static_cast<float>(config_->getDouble("boundary.racing_min_speed", 10.0));
+    racing_params.full_speed_radius = static_cast<float>(config_->getDouble("boundary.racing_full_speed_radius", 300.0));
+    racing_params.accel = static_cast<float>(config_->getDouble("boundary.racing_accel", 2.0));
+    racing_params.brake = static_cast<float>(config_->getDouble("boundary.racing_brake", 4.0));
+    guidance_->setRacingLineParams(racing_params);
+    std::string racing_line = config_->getString("boundary.racing_line", "");
+    if (!racing_line.empty()) {
+        guidance_->loadRacingLine(racing_line);
+    }
+    
+    // Policy table: memory-mapped from tools/track_preprocess output, otherwise cast on the first frame
+    guidance_->setPolicyGrid(config_->getInt("boundary.policy_cell_size", 8),
+                             config_->getInt("boundary.policy_headings", 72));
+    std::string policy_table = config_->getString("boundary.policy_table", "");
+    if (!policy_table.empty()) {
+        guidance_->loadPolicyTable(policy_table);
+    }
+    
+    // Steering: prototype bang-bang, or continuous PID / MPC clipped at control.steering_limit
+    guidance_->setSteeringLimit(config_->getInt("control.steering_limit", 30));
+    SteeringParams steering_params;
+    steering_params.kp = config_->getDouble("control.pid_kp", 0.02);
+    steering_params.ki = config_->getDouble("control.pid_ki", 0.0005);
+    steering_params.kd = config_->getDouble("control.pid_kd", 0.01);
+    steering_params.cross_track_gain = config_->getDouble("control.cross_track_gain", 0.2);
+    steering_params.full_lock_angle = config_->getDouble("control.full_lock_angle", 60.0);
+    steering_params.wheelbase = config_->getDouble("boundary.wheelbase", 40.0);
+    steering_params.horizon = config_->getInt("control.mpc_horizon", 10);
+    steering_params.budget_us = config_->getInt("control.mpc_budget_us", 500);
+    steering_params.effort_weight = config_->getDouble("control.mpc_effort_weight", 20.0);
+    steering_params.rate_weight = config_->getDouble("control.mpc_rate_weight", 2000.0);
+    guidance_->setSteeringParams(steering_params);
+    std::string steering_mode_str = config_->getString("control.steering_mode", "bang_bang");
+    if (steering_mode_str == "pid") {
+        guidance_->setSteeringMode(SteeringMode::PID);
+    } else if (steering_mode_str == "mpc") {
+        guidance_->setSteeringMode(SteeringMode::MPC);
+    } else {
+        guidance_->setSteeringMode(SteeringMode::BANG_BANG);
+    }
+    
+    // Speed: open loop, or regulate the tracked velocity with a map learned during a warm-up lap
+    SpeedParams speed_params;
+    speed_params.kp = config_->getDouble("control.speed_kp", 0.5);
+    speed_params.ki = config_->getDouble("control.speed_ki", 1.0);
+    speed_params.target_scale = config_->getDouble("control.speed_target_scale", 0.0);
+    speed_params.warmup_seconds = config_->getDouble("control.speed_warmup_s", 10.0);
+    int warmup_command = config_->getInt("control.speed_warmup_command", 0);
+    speed_params.warmup_command = warmup_command > 0 ? warmup_command : base_speed_;
+    speed_params.warmup_dither = config_->getInt("control.speed_warmup_dither", 5);
+    speed_params.filter_seconds = config_->getDouble("control.speed_filter_s", 0.2);
+    speed_params.max_command = config_->getInt("control.speed_limit_forward", 100);
+    speed_control_.setParams(speed_params);
+    speed_control_.setMode(config_->getString("control.speed_mode", "open_loop") == "closed_loop"
+                           ? SpeedMode::CLOSED_LOOP : SpeedMode::OPEN_LOOP);
+    
+    // Bird's-eye guidance: undistortion + ground homography tables from tools/ground_calibrate
+    std::string ground_map = config_->getString("boundary.ground_map", "");
+    if (!ground_map.empty()) {
+        guidance_->loadGroundProjection(ground_map);
+    }
+    
     // Initialize BLE handler
     std::string device_mac = config_->getString("ble.device_mac", "f9:af:3c:e2:d2:f5");
     std::string characteristic_uuid = config_->getString("ble.characteristic_uuid", 
@@ -80,6 +184,58 @@ bool ControlOrchestrator::initialize(const std::string& config_file) {
     
     ble_handler_ = std::make_unique<BLEHandler>(device_mac, characteristic_uuid);
     ble_handler_->setCommandRate(command_rate);
+    if (!ble_handler_->setDeviceIdentifier(config_->getString("ble.device_identifier", "bf0a00082800"))) {
+        std::cerr << "Warning: ble.device_identifier must be 12 hex digits, using the default" << std::endl;
+    }
+    if (!ble_handler_->setLightValues(config_->getString("control.light_on_value", "0200"),
+                                      config_->getString("control.light_off_value", "0000"))) {
+        std::cerr << "Warning: control.light_on_value/light_off_value must be 4 hex digits, using the defaults" << std::endl;
+    }
+    ble_handler_->setChecksum(config_->getBool("ble.checksum", false));
+    ble_handler_->setRandomAddress(config_->getString("ble.address_type", "random") != "public");
+    ble_handler_->setConnectionTimeout(static_cast<int>(config_->getDouble("ble.connection_timeout", 5.0) * 1000));
+    
+    // ble.device_mac=mock: runs against an in-process car with these link impairments
+    MockLinkParams mock_link;
+    mock_link.latency_ms = config_->getDouble("ble.mock_latency_ms", 0.0);
+    mock_link.jitter_ms = config_->getDouble("ble.mock_jitter_ms", 0.0);
+    mock_link.loss = config_->getDouble("ble.mock_loss", 0.0);
+    mock_link.seed = static_cast<unsigned>(config_->getInt("ble.mock_seed", 1));
+    ble_handler_->setMockLink(mock_link);
+    
+    // Send policy: fixed-rate stream, or send on change with a keepalive
+    std::string send_policy = config_->getString("ble.send_policy", "fixed_rate");
+    ble_handler_->setSendPolicy(send_policy == "on_change" ? SendPolicy::ON_CHANGE : SendPolicy::FIXED_RATE,
+                                config_->getInt("ble.keepalive_ms", 100),
+                                config_->getDouble("ble.coalesce_ms", 7.5));
+    ble_handler_->setReconnect(config_->getInt("ble.reconnection_attempts", 0),
+                               config_->getInt("ble.reconnect_backoff_ms", 250),
+                               config_->getInt("ble.reconnect_backoff_max_ms", 5000));
+    ble_handler_->setStopBurst(config_->getInt("ble.stop_burst", 5), config_->getDouble("ble.stop_burst_interval_ms", 7.5));
+    
+    // Command shaping: smooth the steps between guidance outputs at the send rate
+    ShapingParams shaping;
+    std::string shaping_mode = config_->getString("ble.shaping", "off");
+    shaping.mode = shaping_mode == "interpolate" ? ShapingMode::INTERPOLATE
+                 : shaping_mode == "extrapolate" ? ShapingMode::EXTRAPOLATE
+                 : ShapingMode::OFF;
+    shaping.horizon = config_->getDouble("ble.shaping_horizon", 1.0);
+    shaping.speed = ChannelLimits(config_->getDouble("ble.speed_rate_limit", 0.0),
+                                  config_->getDouble("ble.speed_jerk_limit", 0.0));
+    shaping.steering = ChannelLimits(config_->getDouble("ble.steering_rate_limit", 0.0),
+                                     config_->getDouble("ble.steering_jerk_limit", 0.0));
+    ble_handler_->setShaping(shaping);
+    if (send_policy == "on_change" && ble_handler_->isShaping()) {
+        std::cerr << "Warning: ble.shaping needs ble.send_policy=fixed_rate, sending unshaped" << std::endl;
+    }
+    max_forward_speed_ = ble_handler_->maxSpeed();
+    if (ble_handler_->isShaping() && (speed_params.max_command > max_forward_speed_ || base_speed_ > max_forward_speed_ ||
+                                      racing_params.max_speed > max_forward_speed_)) {
+        std::cerr << "Warning: Shaped speed is signed (bytes above " << max_forward_speed_
+                  << " mean reverse); forward speed commands are capped at " << max_forward_speed_ << std::endl;
+        speed_params.max_command = std::min(speed_params.max_command, max_forward_speed_);
+        speed_control_.setParams(speed_params);
+    }
     
     // UI settings
     show_ui_ = config_->getBool("system.show_ui", true);
@@ -128,10 +284,10 @@ bool ControlOrchestrator::start() {
         return false;
     }
     
-    // Connect to BLE device
-    if (!ble_handler_->connect()) {
-        std::cerr << "Warning: Failed to connect to BLE device. Continuing without BLE..." << std::endl;
-        // Continue anyway for testing
+    // Connect to BLE device in the background (with reconnects), so start-up never waits for the car
+    bool ble_ready = ble_handler_->startConnectionManager();
+    if (!ble_ready) {
+        std::cerr << "Warning: BLE device misconfigured. Continuing without BLE..." << std::endl;
     }
     
     // Start threads
@@ -143,8 +299,8 @@ bool ControlOrchestrator::start() {
     guidance_thread_ = std::thread(&ControlOrchestrator::guidanceLoop, this);
     ble_thread_ = std::thread(&ControlOrchestrator::bleLoop, this);
     
-    // Start BLE sending
-    if (ble_handler_->isConnected()) {
+    // Start BLE sending (commands count as offline until the link is up)
+    if (ble_ready) {
         ble_handler_->startSending();
     }
     
@@ -188,6 +344,61 @@ void ControlOrchestrator::stop() {
         ble_thread_.join();
     }
     
+    if (guidance_ && guidance_->isCoherentRays()) {
+        const CoherentRayStats& stats = guidance_->getCoherentRayStats();
+        std::cout << "Coherent rays: " << stats.reused << " from last hit (" << stats.closer << " closer), "
+                  << stats.full << " full casts";
+        if (stats.verified > 0) {
+            std::cout << ", " << stats.mismatches << "/" << stats.verified << " verified mismatches";
+        }
+        std::cout << std::endl;
+    }
+    
+    if (speed_control_.getMode() == SpeedMode::CLOSED_LOOP && speed_control_.getMap().valid) {
+        const SpeedMap& map = speed_control_.getMap();
+        std::cout << "Speed map: velocity = " << map.gain << " * command + " << map.offset << std::endl;
+    }
+    if (guidance_ && guidance_->getSteeringMode() == SteeringMode::MPC) {
+        const SteeringStats& stats = guidance_->getSteeringStats();
+        std::cout << "MPC steering: " << stats.cycles << " cycles, " << stats.iterations << " iterations, "
+                  << stats.budget_hits << " at budget, max " << stats.max_solve_us << " us" << std::endl;
+    }
+    if (ble_handler_) {
+        BLEStats stats = ble_handler_->getStats();
+        if (stats.sent + stats.busy + stats.failed + stats.offline > 0) {
+            std::cout << "BLE commands: " << stats.sent << " sent, " << stats.busy << " dropped (link busy), "
+                      << stats.failed << " failed, " << stats.offline << " while disconnected" << std::endl;
+        }
+        SendTimingStats timing = ble_handler_->getTimingStats();
+        if (ble_handler_->getSendPolicy() == SendPolicy::ON_CHANGE) {
+            std::cout << "BLE send on change: " << timing.change_sends << " changes, " << timing.keepalive_sends
+                      << " keepalives, change latency mean " << timing.mean_latency_us << " us, max "
+                      << timing.max_latency_us << " us" << std::endl;
+        } else if (timing.cycles > 0) {
+            std::cout << "BLE send loop: " << timing.cycles << " cycles at " << timing.mean_interval_us
+                      << " us, jitter rms " << timing.jitter_rms_us << " us, max " << timing.jitter_max_us
+                      << " us, " << timing.overruns << " overruns" << std::endl;
+        }
+        ConnectionStats link_stats = ble_handler_->getConnectionStats();
+        if (link_stats.outages > 0 || link_stats.failed_attempts > 0) {
+            std::cout << "BLE link: " << link_stats.outages << " outages (" << link_stats.total_outage_s << " s total, max "
+                      << link_stats.max_outage_s << " s), " << link_stats.failed_attempts << " failed connection attempts"
+                      << std::endl;
+        }
+        StopStats stop_stats = ble_handler_->getStopStats();
+        if (stop_stats.requests > 0) {
+            std::cout << "Emergency stops: " << stop_stats.requests << ", request to link mean "
+                      << stop_stats.mean_latency_us << " us, max " << stop_stats.max_latency_us << " us, "
+                      << stop_stats.blocked_commands << " commands blocked" << std::endl;
+        }
+        const MockTransport* mock = dynamic_cast<const MockTransport*>(ble_handler_->getTransport());
+        if (mock) {
+            MockLinkStats link = mock->getStats();
+            std::cout << "Mock link: " << link.lost << "/" << link.written << " lost, latency mean "
+                      << link.mean_latency_ms << " ms, max " << link.max_latency_ms << " ms" << std::endl;
+        }
+    }
+    
     std::cout << "System stopped" << std::endl;
 }
 
@@ -206,6 +417,7 @@ void ControlOrchestrator::trackingLoop() {
             std::this_thread::sleep_for(std::chrono::milliseconds(10));
             continue;
         }
+        result.timestamp = std::chrono::steady_clock::now();
         
         // Push frame to queue
         frame_queue_.push(frame.clone());
@@ -280,10 +492,25 @@ void ControlOrchestrator::guidanceLoop() {
         if (tracking_result.tracking_lost) {
             // Send stop command if tracking lost
             control = ControlVector(0, 0, 0, 0);
+            speed_control_.reset();
         } else {
             // Process boundary detection
+            guidance_->setCarBBox(tracking_result.bbox);
             control = guidance_->process(frame, tracking_result.midpoint, 
                                         tracking_result.movement, base_speed_);
+            
+            // Guidance speed becomes a velocity target (ground millimetres with a ground projection)
+            if (speed_control_.getMode() == SpeedMode::CLOSED_LOOP) {
+                cv::Point2f tracked(static_cast<float>(tracking_result.midpoint.x),
+                                    static_cast<float>(tracking_result.midpoint.y));
+                const GroundProjection& ground = guidance_->getGroundProjection();
+                if (ground.isValid() && frame.size() == ground.frameSize()) {
+                    tracked = ground.toGround(tracked) * static_cast<float>(ground.unitsPerPixel());
+                }
+                speed_control_.observe(tracked.x, tracked.y, tracking_result.timestamp);
+                control.speed = speed_control_.update(control.speed, tracking_result.timestamp);
+            }
+            control.speed = std::min(control.speed, max_forward_speed_);
         }
         
         // Push control command
@@ -312,7 +539,8 @@ void ControlOrchestrator::bleLoop() {
     ControlVector control;
     
     while (running_) {
-        if (!autonomous_mode_ || !ble_handler_->isConnected()) {
+        // Keep the handler's command current through outages: it is resent on reconnect
+        if (!autonomous_mode_) {
             std::this_thread::sleep_for(std::chrono::milliseconds(10));
             continue;
         }
@@ -333,7 +561,7 @@ void ControlOrchestrator::bleLoop() {
 }
 
 void ControlOrchestrator::setManualControl(const ControlVector& control) {
-    if (ble_handler_ && ble_handler_->isConnected()) {
+    if (ble_handler_) {
         ble_handler_->setControl(control);
     }
 }
@@ -344,4 +572,13 @@ void ControlOrchestrator::emergencyStop() {
     }
 }
 
+void ControlOrchestrator::clearEmergencyStop() {
+    if (ble_handler_) {
+        ble_handler_->clearEmergencyStop();
+        if (ble_handler_->getLinkState() == LinkState::GAVE_UP) {
+            ble_handler_->startConnectionManager();  // Resuming also retries a link that was given up
+        }
+    }
+}
+
 } // namespace rc_car
@@ -0,0 +1,102 @@
+/**
+ * @file distance_field.cpp
+ * @brief Euclidean distance field over the track boundary with sphere-traced ray queries
+ */
+
+#include "distance_field.h"
+#include <cmath>
+#include <algorithm>
+
+namespace rc_car {
+
+namespace {
+// Largest offset between two ray samples m steps apart is m + sqrt(2) (truncation on both axes)
+constexpr float SAMPLE_SLACK = 1.415f;
+}
+
+void DistanceField::build(const cv::Mat& boundary_mask, int max_distance) {
+    if (boundary_mask.empty()) {
+        clear();
+        return;
+    }
+
+    // distanceTransform measures distance to the nearest zero pixel, so boundary pixels must be 0
+    cv::Mat free_mask;
+    cv::threshold(boundary_mask, free_mask, 0, 255, cv::THRESH_BINARY_INV);
+    cv::distanceTransform(free_mask, distance_, cv::DIST_L2, cv::DIST_MASK_PRECISE, CV_32F);
+    if (max_distance > 0) {
+        cv::min(distance_, static_cast<double>(max_distance), distance_);
+    }
+}
+
+void DistanceField::update(const cv::Mat& boundary_mask, const cv::Rect& region, int max_distance) {
+    if (!isValid() || boundary_mask.size() != distance_.size()) {
+        build(boundary_mask, max_distance);
+        return;
+    }
+
+    // With the field capped at D, a changed pixel can only affect values within D of it, and
+    // those values only depend on boundary pixels within another D. So recompute over the region
+    // grown by 2D and write back the region grown by D; outside the ROI counts as free space.
+    cv::Rect frame(0, 0, distance_.cols, distance_.rows);
+    cv::Rect affected = cv::Rect(region.x - max_distance, region.y - max_distance,
+                                 region.width + 2 * max_distance, region.height + 2 * max_distance) & frame;
+    cv::Rect window = cv::Rect(region.x - 2 * max_distance, region.y - 2 * max_distance,
+                               region.width + 4 * max_distance, region.height + 4 * max_distance) & frame;
+
+    cv::Mat free_mask;
+    cv::Mat window_distance;
+    cv::threshold(boundary_mask(window), free_mask, 0, 255, cv::THRESH_BINARY_INV);
+    cv::distanceTransform(free_mask, window_distance, cv::DIST_L2, cv::DIST_MASK_PRECISE, CV_32F);
+    cv::min(window_distance, static_cast<double>(max_distance), window_distance);
+
+    cv::Rect inner = affected - window.tl();
+    cv::Mat target = distance_(affected);
+    window_distance(inner).copyTo(target);
+}
+
+void DistanceField::clear() {
+    distance_.release();
+}
+
+float DistanceField::clearanceAt(int x, int y) const {
+    if (x < 0 || x >= distance_.cols || y < 0 || y >= distance_.rows) {
+        return 0.0f;
+    }
+
+    // The first pixel outside the frame is a wall as well
+    int edge = std::min(std::min(x + 1, y + 1), std::min(distance_.cols - x, distance_.rows - y));
+    return std::min(distance_.at<float>(y, x), static_cast<float>(edge));
+}
+
+float DistanceField::distanceToWall(const Position& pos) const {
+    if (!isValid()) {
+        return 0.0f;
+    }
+    return clearanceAt(pos.x, pos.y);
+}
+
+int DistanceField::castRay(const Position& start, const RayDirection& dir, int min_distance, int max_distance) const {
+    if (!isValid()) {
+        return min_distance;
+    }
+
+    // Samples are the same as the pixel-marching caster; every sample within
+    // clearance - SAMPLE_SLACK steps of a free sample is guaranteed free, so skip them
+    int i = min_distance;
+    while (i < max_distance) {
+        int x = start.x + static_cast<int>(dir.dx * i);
+        int y = start.y + static_cast<int>(dir.dy * i);
+
+        float clearance = clearanceAt(x, y);
+        if (clearance <= 0.0f) {
+            return i;
+        }
+
+        i += std::max(1, static_cast<int>(std::ceil(clearance - SAMPLE_SLACK)));
+    }
+
+    return max_distance;
+}
+
+} // namespace rc_car
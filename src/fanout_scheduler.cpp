@@ -0,0 +1,241 @@
+/**
+ * @file fanout_scheduler.cpp
+ * @brief Single-thread command scheduler for several cars sharing one BLE adapter
+ */
+
+#include "fanout_scheduler.h"
+#include <algorithm>
+#include <iostream>
+
+namespace rc_car {
+
+FanoutScheduler::FanoutScheduler(int budget_pps, int burst)
+    : budget_pps_(std::max(0, budget_pps)), burst_(std::max(1, burst)), virtual_time_(0.0), reconnect_ms_(1000),
+      running_(false) {
+}
+
+FanoutScheduler::~FanoutScheduler() {
+    stop();
+}
+
+int FanoutScheduler::addVehicle(const VehicleParams& params, std::unique_ptr<BLETransport> transport,
+                                const CommandEncoder& encoder) {
+    if (running_ || !transport) {
+        std::cerr << "Warning: Vehicles must be added with a transport before the scheduler starts" << std::endl;
+        return -1;
+    }
+    std::unique_ptr<Vehicle> vehicle(new Vehicle());
+    vehicle->params = params;
+    vehicle->params.rate_hz = std::max(1, params.rate_hz);
+    vehicle->encoder = encoder;
+    vehicle->transport = std::move(transport);
+    vehicle->period = std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+        std::chrono::duration<double>(1.0 / vehicle->params.rate_hz));
+    vehicle->lateness_sum_us = 0.0;
+    vehicle->weight = std::max(0, params.priority) + 1.0;
+    vehicle->start_tag = vehicle->finish_tag = 0.0;
+    vehicles_.push_back(std::move(vehicle));
+    return static_cast<int>(vehicles_.size()) - 1;
+}
+
+bool FanoutScheduler::connectAll() {
+    bool all = true;
+    for (auto& vehicle : vehicles_) {
+        if (!vehicle->transport->isConnected() && !vehicle->transport->connect()) {
+            std::cerr << "Warning: Could not connect to " << vehicle->params.name << std::endl;
+            all = false;
+        }
+    }
+    return all;
+}
+
+void FanoutScheduler::start() {
+    if (running_ || vehicles_.empty()) {
+        return;
+    }
+
+    // Stagger the first slots so links with equal rates do not all fall due together
+    auto now = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < vehicles_.size(); ++i) {
+        Vehicle& vehicle = *vehicles_[i];
+        vehicle.deadline = now + vehicle.period * static_cast<long>(i) / static_cast<long>(vehicles_.size());
+        std::lock_guard<std::mutex> lock(stats_mutex_);
+        vehicle.stats = VehicleStats();
+        vehicle.lateness_sum_us = 0.0;
+        vehicle.start_tag = vehicle.finish_tag = 0.0;
+    }
+    due_.reserve(vehicles_.size());
+    virtual_time_ = 0.0;
+    started_ = now;
+
+    running_ = true;
+    thread_ = std::thread(&FanoutScheduler::run, this);
+    if (reconnect_ms_ > 0) {
+        reconnect_thread_ = std::thread(&FanoutScheduler::reconnectLoop, this);
+    }
+}
+
+void FanoutScheduler::stop() {
+    {
+        std::lock_guard<std::mutex> lock(wake_mutex_);
+        running_ = false;
+    }
+    wake_cv_.notify_all();
+    if (thread_.joinable()) {
+        thread_.join();
+        stopped_ = std::chrono::steady_clock::now();
+    }
+    if (reconnect_thread_.joinable()) {
+        // A connect in progress gives up rather than running to its timeout
+        for (auto& vehicle : vehicles_) {
+            vehicle->transport->abortConnect();
+        }
+        reconnect_thread_.join();
+        for (auto& vehicle : vehicles_) {
+            vehicle->transport->resumeConnect();
+        }
+    }
+}
+
+void FanoutScheduler::setControl(int vehicle, const ControlVector& control) {
+    if (vehicle >= 0 && static_cast<size_t>(vehicle) < vehicles_.size()) {
+        vehicles_[vehicle]->control.store(control);
+    }
+}
+
+void FanoutScheduler::sendTo(Vehicle& vehicle, std::chrono::steady_clock::time_point now) {
+    WriteResult result = WriteResult::FAILED;
+    bool online = vehicle.transport->isConnected();
+    if (online) {
+        CommandEncoder::Packet packet;
+        vehicle.encoder.encode(vehicle.control.load(), packet);
+        result = vehicle.transport->write(packet.data(), packet.size());
+    }
+    double lateness_us = std::chrono::duration<double, std::micro>(now - vehicle.deadline).count();
+
+    // Next slot on the grid; slots already missed are dropped, not sent back to back
+    vehicle.deadline += vehicle.period;
+    long missed = 0;
+    if (vehicle.deadline <= now) {
+        missed = static_cast<long>((now - vehicle.deadline) / vehicle.period) + 1;
+        vehicle.deadline += missed * vehicle.period;
+    }
+
+    std::lock_guard<std::mutex> lock(stats_mutex_);
+    VehicleStats& stats = vehicle.stats;
+    stats.deferred += missed;
+    if (!online) {
+        ++stats.offline;
+        return;
+    }
+    switch (result) {
+    case WriteResult::OK:
+        ++stats.sent;
+        break;
+    case WriteResult::BUSY:
+        ++stats.busy;
+        break;
+    case WriteResult::FAILED:
+        ++stats.failed;
+        break;
+    }
+    vehicle.lateness_sum_us += lateness_us;
+    stats.max_lateness_us = std::max(stats.max_lateness_us, lateness_us);
+}
+
+void FanoutScheduler::run() {
+    using Clock = std::chrono::steady_clock;
+    double tokens = burst_;
+    Clock::time_point refilled = Clock::now();
+
+    while (running_) {
+        Clock::time_point now = Clock::now();
+        if (budget_pps_ > 0) {
+            tokens = std::min<double>(burst_, tokens + std::chrono::duration<double>(now - refilled).count() * budget_pps_);
+            refilled = now;
+        }
+
+        // Due links by fair queuing tag, then the one waiting longest. A link that was idle
+        // starts from the current virtual time, so it cannot bank credit for a burst.
+        due_.clear();
+        for (auto& vehicle : vehicles_) {
+            if (vehicle->deadline <= now) {
+                vehicle->start_tag = std::max(vehicle->finish_tag, virtual_time_);
+                due_.push_back(vehicle.get());
+            }
+        }
+        std::sort(due_.begin(), due_.end(), [](const Vehicle* a, const Vehicle* b) {
+            if (a->start_tag != b->start_tag) {
+                return a->start_tag < b->start_tag;
+            }
+            return a->deadline < b->deadline;
+        });
+
+        size_t served = 0;
+        for (; served < due_.size(); ++served) {
+            if (budget_pps_ > 0 && tokens < 1.0) {
+                break;  // Adapter budget spent: the rest stay due and lead the next round
+            }
+            Vehicle& vehicle = *due_[served];
+            virtual_time_ = vehicle.start_tag;
+            vehicle.finish_tag = vehicle.start_tag + 1.0 / vehicle.weight;
+            sendTo(vehicle, Clock::now());
+            if (budget_pps_ > 0) {
+                tokens -= 1.0;
+            }
+        }
+
+        // Sleep to the next slot, or until the bucket has a token for a link still waiting
+        Clock::time_point wake = Clock::time_point::max();
+        for (const auto& vehicle : vehicles_) {
+            wake = std::min(wake, vehicle->deadline);
+        }
+        if (served < due_.size()) {
+            wake = Clock::now() + std::chrono::duration_cast<Clock::duration>(
+                                      std::chrono::duration<double>((1.0 - tokens) / budget_pps_));
+        }
+        std::unique_lock<std::mutex> lock(wake_mutex_);
+        wake_cv_.wait_until(lock, wake, [this] { return !running_; });
+    }
+}
+
+void FanoutScheduler::reconnectLoop() {
+    // Only this thread connects while running; the scheduler never writes to a link that is down
+    std::unique_lock<std::mutex> lock(wake_mutex_);
+    while (running_) {
+        wake_cv_.wait_for(lock, std::chrono::milliseconds(reconnect_ms_), [this] { return !running_; });
+        lock.unlock();
+        for (auto& vehicle : vehicles_) {
+            if (!running_) {
+                break;
+            }
+            if (!vehicle->transport->isConnected() && vehicle->transport->connect()) {
+                std::cout << "Reconnected to " << vehicle->params.name << std::endl;
+                std::lock_guard<std::mutex> stats_lock(stats_mutex_);
+                ++vehicle->stats.reconnects;
+            }
+        }
+        lock.lock();
+    }
+}
+
+VehicleStats FanoutScheduler::getStats(int vehicle) const {
+    if (vehicle < 0 || static_cast<size_t>(vehicle) >= vehicles_.size()) {
+        return VehicleStats();
+    }
+    const Vehicle& v = *vehicles_[vehicle];
+    std::lock_guard<std::mutex> lock(stats_mutex_);
+    VehicleStats stats = v.stats;
+    long written = stats.sent + stats.busy + stats.failed;
+    if (written > 0) {
+        stats.mean_lateness_us = v.lateness_sum_us / written;
+    }
+    auto end = running_ ? std::chrono::steady_clock::now() : stopped_;
+    double elapsed = std::chrono::duration<double>(end - started_).count();
+    if (elapsed > 0.0) {
+        stats.achieved_hz = stats.sent / elapsed;
+    }
+    return stats;
+}
+
+} // namespace rc_car
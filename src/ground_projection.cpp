@@ -0,0 +1,230 @@
+/**
+ * @file ground_projection.cpp
+ * @brief Fixed-point undistortion + bird's-eye remap tables and point mapping between image and ground
+ */
+
+#include "ground_projection.h"
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+namespace rc_car {
+
+namespace {
+
+// On-disk layout (little-endian): header, CV_16SC2 map, then CV_16UC1 map
+struct TableHeader {
+    char magic[4];       // "RCGP"
+    uint16_t version;
+    uint16_t reserved;
+    int32_t frame_width;
+    int32_t frame_height;
+    int32_t width;
+    int32_t height;
+    double units_per_pixel;
+    double camera_matrix[9];
+    double distortion[5];
+    double homography[9];
+};
+
+static_assert(sizeof(TableHeader) == 216, "Ground projection header must stay 216 bytes");
+
+constexpr char TABLE_MAGIC[4] = {'R', 'C', 'G', 'P'};
+constexpr uint16_t TABLE_VERSION = 1;
+constexpr int MAX_GRID = 8192;  // Per axis; keeps the int16 tables meaningful
+
+// Row-major 3x3 helpers
+void multiply3x3(const double* a, const double* b, double* out) {
+    for (int r = 0; r < 3; ++r) {
+        for (int c = 0; c < 3; ++c) {
+            out[r * 3 + c] = a[r * 3] * b[c] + a[r * 3 + 1] * b[3 + c] + a[r * 3 + 2] * b[6 + c];
+        }
+    }
+}
+
+bool invert3x3(const double* m, double* out) {
+    double c0 = m[4] * m[8] - m[5] * m[7];
+    double c1 = m[5] * m[6] - m[3] * m[8];
+    double c2 = m[3] * m[7] - m[4] * m[6];
+    double det = m[0] * c0 + m[1] * c1 + m[2] * c2;
+    if (std::abs(det) < 1e-12) {
+        return false;
+    }
+    double inv = 1.0 / det;
+    out[0] = c0 * inv;
+    out[1] = (m[2] * m[7] - m[1] * m[8]) * inv;
+    out[2] = (m[1] * m[5] - m[2] * m[4]) * inv;
+    out[3] = c1 * inv;
+    out[4] = (m[0] * m[8] - m[2] * m[6]) * inv;
+    out[5] = (m[2] * m[3] - m[0] * m[5]) * inv;
+    out[6] = c2 * inv;
+    out[7] = (m[1] * m[6] - m[0] * m[7]) * inv;
+    out[8] = (m[0] * m[4] - m[1] * m[3]) * inv;
+    return true;
+}
+
+cv::Point2f applyHomography(const double* h, double x, double y) {
+    double w = h[6] * x + h[7] * y + h[8];
+    if (std::abs(w) < 1e-12) {
+        w = 1e-12;
+    }
+    return cv::Point2f(static_cast<float>((h[0] * x + h[1] * y + h[2]) / w),
+                       static_cast<float>((h[3] * x + h[4] * y + h[5]) / w));
+}
+
+} // namespace
+
+GroundProjection::GroundProjection() {
+    std::memset(&calib_, 0, sizeof(calib_));
+    std::memset(inverse_, 0, sizeof(inverse_));
+}
+
+void GroundProjection::clear() {
+    map_xy_.release();
+    map_frac_.release();
+    mapping_.close();
+}
+
+bool GroundProjection::setCalibration(const GroundCalibration& calib) {
+    if (calib.width <= 0 || calib.height <= 0 || calib.width > MAX_GRID || calib.height > MAX_GRID ||
+        calib.frame_width <= 0 || calib.frame_height <= 0 || !invert3x3(calib.homography, inverse_)) {
+        std::cerr << "Error: Invalid ground calibration" << std::endl;
+        return false;
+    }
+    calib_ = calib;
+    return true;
+}
+
+bool GroundProjection::build(const GroundCalibration& calib) {
+    clear();
+    if (!setCalibration(calib)) {
+        return false;
+    }
+
+    // initUndistortRectifyMap inverts (P * R) to get from a destination pixel to normalised
+    // camera coordinates. With P = I and R = H * K that is K^-1 * H^-1: bird's-eye pixel ->
+    // undistorted pixel -> normalised, after which it applies the lens model and K.
+    double rectify[9];
+    multiply3x3(calib_.homography, calib_.camera_matrix, rectify);
+    cv::Mat camera(3, 3, CV_64F, calib_.camera_matrix);
+    cv::Mat distortion(1, 5, CV_64F, calib_.distortion);
+    cv::Mat r(3, 3, CV_64F, rectify);
+    cv::initUndistortRectifyMap(camera, distortion, r, cv::Mat::eye(3, 3, CV_64F),
+                                cv::Size(calib_.width, calib_.height), CV_16SC2, map_xy_, map_frac_);
+    return isValid();
+}
+
+bool GroundProjection::save(const std::string& path) const {
+    if (!isValid()) {
+        std::cerr << "Error: No ground projection to save" << std::endl;
+        return false;
+    }
+
+    std::ofstream file(path, std::ios::binary);
+    if (!file.is_open()) {
+        std::cerr << "Error: Could not write ground projection: " << path << std::endl;
+        return false;
+    }
+
+    TableHeader header;
+    std::memcpy(header.magic, TABLE_MAGIC, sizeof(header.magic));
+    header.version = TABLE_VERSION;
+    header.reserved = 0;
+    header.frame_width = calib_.frame_width;
+    header.frame_height = calib_.frame_height;
+    header.width = calib_.width;
+    header.height = calib_.height;
+    header.units_per_pixel = calib_.units_per_pixel;
+    std::memcpy(header.camera_matrix, calib_.camera_matrix, sizeof(header.camera_matrix));
+    std::memcpy(header.distortion, calib_.distortion, sizeof(header.distortion));
+    std::memcpy(header.homography, calib_.homography, sizeof(header.homography));
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+    for (int y = 0; y < map_xy_.rows; ++y) {
+        file.write(reinterpret_cast<const char*>(map_xy_.ptr<short>(y)), map_xy_.cols * 2 * sizeof(short));
+    }
+    for (int y = 0; y < map_frac_.rows; ++y) {
+        file.write(reinterpret_cast<const char*>(map_frac_.ptr<ushort>(y)), map_frac_.cols * sizeof(ushort));
+    }
+    return file.good();
+}
+
+bool GroundProjection::load(const std::string& path) {
+    clear();
+    if (!mapping_.open(path)) {
+        std::cerr << "Error: Could not map ground projection: " << path << std::endl;
+        return false;
+    }
+
+    TableHeader header;
+    if (mapping_.size() < sizeof(header) || std::memcmp(mapping_.data(), TABLE_MAGIC, sizeof(header.magic)) != 0) {
+        std::cerr << "Error: Not a ground projection table: " << path << std::endl;
+        clear();
+        return false;
+    }
+    std::memcpy(&header, mapping_.data(), sizeof(header));
+    if (header.version != TABLE_VERSION) {
+        std::cerr << "Error: Unsupported ground projection version " << header.version << " in " << path << std::endl;
+        clear();
+        return false;
+    }
+
+    GroundCalibration calib;
+    calib.frame_width = header.frame_width;
+    calib.frame_height = header.frame_height;
+    calib.width = header.width;
+    calib.height = header.height;
+    calib.units_per_pixel = header.units_per_pixel;
+    std::memcpy(calib.camera_matrix, header.camera_matrix, sizeof(calib.camera_matrix));
+    std::memcpy(calib.distortion, header.distortion, sizeof(calib.distortion));
+    std::memcpy(calib.homography, header.homography, sizeof(calib.homography));
+    if (!setCalibration(calib)) {
+        clear();
+        return false;
+    }
+
+    size_t pixels = static_cast<size_t>(calib.width) * calib.height;
+    if (mapping_.size() != sizeof(header) + pixels * (2 * sizeof(short) + sizeof(ushort))) {
+        std::cerr << "Error: Truncated ground projection table: " << path << std::endl;
+        clear();
+        return false;
+    }
+
+    // The maps are used in place from the read-only mapping (cv::remap never writes them)
+    uint8_t* bytes = const_cast<uint8_t*>(mapping_.data()) + sizeof(header);
+    map_xy_ = cv::Mat(calib.height, calib.width, CV_16SC2, bytes);
+    map_frac_ = cv::Mat(calib.height, calib.width, CV_16UC1, bytes + pixels * 2 * sizeof(short));
+    return true;
+}
+
+cv::Point2f GroundProjection::toGround(const cv::Point2f& image_point) const {
+    std::vector<cv::Point2f> distorted(1, image_point);
+    std::vector<cv::Point2f> undistorted;
+    cv::Mat camera(3, 3, CV_64F, const_cast<double*>(calib_.camera_matrix));
+    cv::Mat distortion(1, 5, CV_64F, const_cast<double*>(calib_.distortion));
+    cv::undistortPoints(distorted, undistorted, camera, distortion, cv::Mat(), camera);
+    return applyHomography(calib_.homography, undistorted[0].x, undistorted[0].y);
+}
+
+cv::Point2f GroundProjection::toImage(const cv::Point2f& ground_point) const {
+    cv::Point2f p = applyHomography(inverse_, ground_point.x, ground_point.y);
+
+    // Same lens model as initUndistortRectifyMap
+    const double* k = calib_.camera_matrix;
+    const double* d = calib_.distortion;
+    double x = (p.x - k[2]) / k[0];
+    double y = (p.y - k[5]) / k[4];
+    double r2 = x * x + y * y;
+    double radial = 1.0 + r2 * (d[0] + r2 * (d[1] + r2 * d[4]));
+    double xd = x * radial + 2.0 * d[2] * x * y + d[3] * (r2 + 2.0 * x * x);
+    double yd = y * radial + d[2] * (r2 + 2.0 * y * y) + 2.0 * d[3] * x * y;
+    return cv::Point2f(static_cast<float>(k[0] * xd + k[2]), static_cast<float>(k[4] * yd + k[5]));
+}
+
+void GroundProjection::warp(const cv::Mat& frame, const cv::Rect& region, cv::Mat& out) const {
+    cv::remap(frame, out, map_xy_(region), map_frac_(region), cv::INTER_LINEAR, cv::BORDER_CONSTANT, cv::Scalar());
+}
+
+} // namespace rc_car
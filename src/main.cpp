@@ -111,6 +111,12 @@ int main(int argc, char* argv[]) {
             if (key == 'q' || key == 27) {  // 'q' or ESC
                 std::cout << "\nQuit key pressed. Shutting down..." << std::endl;
                 break;
+            } else if (key == ' ') {
+                std::cout << "Emergency stop (press 'r' to resume)" << std::endl;
+                g_orchestrator->emergencyStop();
+            } else if (key == 'r') {
+                std::cout << "Emergency stop cleared" << std::endl;
+                g_orchestrator->clearEmergencyStop();
             }
         }
     }
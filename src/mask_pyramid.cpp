@@ -0,0 +1,125 @@
+/**
+ * @file mask_pyramid.cpp
+ * @brief Max-mip pyramid over a boundary mask and empty-space skipping ray casts
+ */
+
+#include "mask_pyramid.h"
+#include <algorithm>
+#include <cmath>
+
+namespace rc_car {
+
+namespace {
+
+// First sample index at which the ray leaves [lo, hi] along one axis (estimate, may be off by one)
+double exitSample(int start, double d, int sign, int lo, int hi) {
+    double a = std::abs(d);
+    if (a == 0.0) {
+        return HUGE_VAL;
+    }
+    int t = sign > 0 ? hi + 1 - start : start - lo + 1;
+    return std::ceil(t / a);
+}
+
+} // namespace
+
+void MaskPyramid::build(const cv::Mat& boundary_mask, int levels) {
+    // Stop once a level is a single block; existing levels are reused across frames
+    int count = 1;
+    for (int size = std::max(boundary_mask.cols, boundary_mask.rows); count < levels && size > 1; ++count) {
+        size = (size + 1) / 2;
+    }
+    levels_.resize(count);
+    levels_[0] = boundary_mask;
+
+    for (int k = 1; k < count; ++k) {
+        const cv::Mat& fine = levels_[k - 1];
+        cv::Mat& coarse = levels_[k];
+        coarse.create((fine.rows + 1) / 2, (fine.cols + 1) / 2, CV_8UC1);
+
+        for (int y = 0; y < coarse.rows; ++y) {
+            const uchar* r0 = fine.ptr<uchar>(2 * y);
+            const uchar* r1 = fine.ptr<uchar>(std::min(2 * y + 1, fine.rows - 1));
+            uchar* out = coarse.ptr<uchar>(y);
+            int x = 0;
+            for (; 2 * x + 1 < fine.cols; ++x) {
+                out[x] = r0[2 * x] | r0[2 * x + 1] | r1[2 * x] | r1[2 * x + 1];
+            }
+            if (x < coarse.cols) {
+                out[x] = r0[2 * x] | r1[2 * x];  // Odd width: last block is one column wide
+            }
+        }
+    }
+}
+
+int MaskPyramid::castRay(const Position& start, const RayDirection& dir, int min_distance, int max_distance) const {
+    const cv::Mat& base = levels_[0];
+    int top = levels() - 1;
+    int level = 0;
+
+    int i = min_distance;
+    while (i < max_distance) {
+        Position p = MaskRayCaster::sampleAt(start, dir, i);
+        if (p.x < 0 || p.x >= base.cols || p.y < 0 || p.y >= base.rows) {
+            return i;
+        }
+
+        // Coarsest free block around the sample (level 0 = the pixel itself)
+        while (level > 0 && levels_[level].ptr<uchar>(p.y >> level)[p.x >> level]) {
+            --level;
+        }
+        if (level == 0 && base.ptr<uchar>(p.y)[p.x]) {
+            return i;
+        }
+        while (level < top && !levels_[level + 1].ptr<uchar>(p.y >> (level + 1))[p.x >> (level + 1)]) {
+            ++level;
+        }
+        if (level == 0) {
+            ++i;
+            continue;
+        }
+
+        // Skip to the first sample past the block (clipped to the frame: outside it is a hit)
+        int x0 = (p.x >> level) << level;
+        int y0 = (p.y >> level) << level;
+        int x1 = std::min(x0 + (1 << level), base.cols) - 1;
+        int y1 = std::min(y0 + (1 << level), base.rows) - 1;
+        double exit = std::min(exitSample(start.x, dir.dx, dir.sign_x, x0, x1),
+                               exitSample(start.y, dir.dy, dir.sign_y, y0, y1));
+        int next = static_cast<int>(std::min(exit, static_cast<double>(max_distance)));
+
+        // Sample coordinates are monotone along the ray, so if the last skipped sample is still
+        // in the block every skipped one is; this absorbs rounding in the estimate
+        while (next - 1 > i) {
+            Position q = MaskRayCaster::sampleAt(start, dir, next - 1);
+            if (q.x >= x0 && q.x <= x1 && q.y >= y0 && q.y <= y1) {
+                break;
+            }
+            --next;
+        }
+        i = std::max(i + 1, next);
+    }
+    return max_distance;
+}
+
+int MaskPyramid::castRayFrom(const Position& start, const RayDirection& dir, int min_distance, int max_distance,
+                             int previous, bool* closer) const {
+    previous = std::max(min_distance, std::min(previous, max_distance));
+    int hit = castRay(start, dir, min_distance, previous);
+    if (closer) {
+        *closer = hit < previous;
+    }
+    if (hit < previous) {
+        return hit;
+    }
+
+    // Near the wall the pyramid would descend to level 0 anyway, so sample plainly first
+    int near_end = std::min(max_distance, previous + OUTWARD_SAMPLES);
+    hit = MaskRayCaster::castRay(levels_[0], start, dir, previous, near_end);
+    if (hit < near_end) {
+        return hit;
+    }
+    return castRay(start, dir, near_end, max_distance);
+}
+
+} // namespace rc_car
@@ -0,0 +1,103 @@
+/**
+ * @file mock_transport.cpp
+ * @brief In-process stand-in for the car with configurable latency, jitter and loss
+ */
+
+#include "mock_transport.h"
+#include <algorithm>
+
+namespace rc_car {
+
+MockTransport::MockTransport(const MockLinkParams& params)
+    : params_(params), rng_(params.seed), unit_(0.0, 1.0),
+      ring_(std::max<size_t>(1, params.history)), stored_(0), drained_(0),
+      connected_(false), written_(0), lost_(0), latency_sum_ms_(0.0), max_latency_ms_(0.0) {
+}
+
+bool MockTransport::connect() {
+    connected_ = true;
+    return true;
+}
+
+void MockTransport::disconnect() {
+    connected_ = false;
+}
+
+WriteResult MockTransport::write(const uint8_t* data, size_t size) {
+    if (!connected_ || size != CommandEncoder::PACKET_SIZE) {
+        return WriteResult::FAILED;
+    }
+    auto now = std::chrono::steady_clock::now();
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    ++written_;
+    if (params_.loss > 0.0 && unit_(rng_) < params_.loss) {
+        ++lost_;
+        return WriteResult::OK;  // The sender cannot tell: write without response
+    }
+
+    double delay_ms = params_.latency_ms + (params_.jitter_ms > 0.0 ? params_.jitter_ms * unit_(rng_) : 0.0);
+    auto delivered = now + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                               std::chrono::duration<double, std::milli>(delay_ms));
+    if (stored_ > 0 && delivered < last_delivery_) {
+        delivered = last_delivery_;  // In order: wait behind the previous command
+    }
+    last_delivery_ = delivered;
+
+    ReceivedCommand& slot = ring_[stored_ % ring_.size()];
+    std::copy(data, data + size, slot.packet.begin());
+    slot.sent = now;
+    slot.delivered = delivered;
+    ++stored_;
+
+    double latency_ms = std::chrono::duration<double, std::milli>(delivered - now).count();
+    latency_sum_ms_ += latency_ms;
+    max_latency_ms_ = std::max(max_latency_ms_, latency_ms);
+    return WriteResult::OK;
+}
+
+size_t MockTransport::takeDelivered(std::vector<ReceivedCommand>& out, std::chrono::steady_clock::time_point now) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    // Commands overwritten before the harness got to them are skipped
+    if (stored_ - drained_ > ring_.size()) {
+        drained_ = stored_ - ring_.size();
+    }
+    size_t taken = 0;
+    while (drained_ < stored_) {
+        const ReceivedCommand& command = ring_[drained_ % ring_.size()];
+        if (command.delivered > now) {
+            break;  // Still in flight; everything after it is too
+        }
+        out.push_back(command);
+        ++drained_;
+        ++taken;
+    }
+    return taken;
+}
+
+bool MockTransport::commandAt(std::chrono::steady_clock::time_point time, CommandEncoder::Packet& packet) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    uint64_t oldest = stored_ > ring_.size() ? stored_ - ring_.size() : 0;
+    // Delivery times are non-decreasing, so the newest one not after `time` is the command in effect
+    for (uint64_t i = stored_; i > oldest; --i) {
+        const ReceivedCommand& command = ring_[(i - 1) % ring_.size()];
+        if (command.delivered <= time) {
+            packet = command.packet;
+            return true;
+        }
+    }
+    return false;
+}
+
+MockLinkStats MockTransport::getStats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    MockLinkStats stats;
+    stats.written = written_;
+    stats.lost = lost_;
+    long delivered = written_ - lost_;
+    stats.mean_latency_ms = delivered > 0 ? latency_sum_ms_ / delivered : 0.0;
+    stats.max_latency_ms = max_latency_ms_;
+    return stats;
+}
+
+} // namespace rc_car
@@ -0,0 +1,247 @@
+/**
+ * @file policy_table.cpp
+ * @brief Parallel precomputation, memory-mapped storage and trilinear lookup of ray distances per pose
+ */
+
+#include "policy_table.h"
+#include "ray_caster.h"
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <thread>
+#include <algorithm>
+
+namespace rc_car {
+
+namespace {
+
+// On-disk layout (little-endian): header, `rays` float angles, then uint16 samples
+struct TableHeader {
+    char magic[4];       // "RCPT"
+    uint16_t version;
+    uint16_t rays;
+    int32_t cell_size;
+    int32_t cols;
+    int32_t rows;
+    int32_t headings;
+    int32_t min_length;
+    int32_t max_length;
+};
+
+static_assert(sizeof(TableHeader) == 32, "Policy table header must stay 32 bytes");
+
+constexpr char TABLE_MAGIC[4] = {'R', 'C', 'P', 'T'};
+constexpr uint16_t TABLE_VERSION = 1;
+constexpr int MAX_STORED_LENGTH = 65535;
+
+} // namespace
+
+PolicyTable::PolicyTable()
+    : data_(nullptr), cell_size_(0), cols_(0), rows_(0), headings_(0), min_length_(0), max_length_(0) {
+}
+
+void PolicyTable::clear() {
+    mapping_.close();
+    storage_.clear();
+    storage_.shrink_to_fit();
+    data_ = nullptr;
+    cols_ = rows_ = headings_ = 0;
+    ray_angles_.clear();
+}
+
+bool PolicyTable::build(const cv::Mat& boundary_mask, const std::vector<double>& ray_angles, int cell_size,
+                        int headings, int min_length, int max_length, int threads) {
+    clear();
+    if (boundary_mask.empty() || boundary_mask.type() != CV_8UC1 || ray_angles.empty() ||
+        cell_size < 1 || headings < 1 || max_length > MAX_STORED_LENGTH) {
+        std::cerr << "Error: Invalid policy table parameters" << std::endl;
+        return false;
+    }
+
+    cell_size_ = cell_size;
+    cols_ = (boundary_mask.cols + cell_size - 1) / cell_size;
+    rows_ = (boundary_mask.rows + cell_size - 1) / cell_size;
+    headings_ = headings;
+    min_length_ = min_length;
+    max_length_ = max_length;
+    ray_angles_ = ray_angles;
+    int rays = static_cast<int>(ray_angles.size());
+
+    // Directions for every (heading bin, ray) pair, shared by all cells
+    std::vector<RayDirection> directions(static_cast<size_t>(headings) * rays);
+    for (int h = 0; h < headings; ++h) {
+        for (int r = 0; r < rays; ++r) {
+            directions[h * rays + r] = RayDirection(360.0 * h / headings + ray_angles[r]);
+        }
+    }
+
+    size_t row_stride = static_cast<size_t>(cols_) * headings * rays;
+    storage_.assign(row_stride * rows_, 0);
+
+    if (threads <= 0) {
+        threads = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+    }
+    threads = std::min(threads, rows_);
+
+    // Interleave rows across workers so the track's cost is spread evenly
+    auto worker = [&](int first_row) {
+        for (int row = first_row; row < rows_; row += threads) {
+            uint16_t* out = storage_.data() + row * row_stride;
+            int y = std::min(boundary_mask.rows - 1, row * cell_size + cell_size / 2);
+            for (int col = 0; col < cols_; ++col) {
+                Position start(std::min(boundary_mask.cols - 1, col * cell_size + cell_size / 2), y);
+                for (size_t k = 0; k < directions.size(); ++k) {
+                    *out++ = static_cast<uint16_t>(
+                        MaskRayCaster::castRay(boundary_mask, start, directions[k], min_length, max_length));
+                }
+            }
+        }
+    };
+
+    std::vector<std::thread> pool;
+    for (int t = 1; t < threads; ++t) {
+        pool.emplace_back(worker, t);
+    }
+    worker(0);
+    for (auto& thread : pool) {
+        thread.join();
+    }
+
+    data_ = storage_.data();
+    return true;
+}
+
+bool PolicyTable::save(const std::string& path) const {
+    if (!isValid()) {
+        std::cerr << "Error: No policy table to save" << std::endl;
+        return false;
+    }
+
+    std::ofstream file(path, std::ios::binary);
+    if (!file.is_open()) {
+        std::cerr << "Error: Could not write policy table: " << path << std::endl;
+        return false;
+    }
+
+    TableHeader header;
+    std::memcpy(header.magic, TABLE_MAGIC, sizeof(header.magic));
+    header.version = TABLE_VERSION;
+    header.rays = static_cast<uint16_t>(ray_angles_.size());
+    header.cell_size = cell_size_;
+    header.cols = cols_;
+    header.rows = rows_;
+    header.headings = headings_;
+    header.min_length = min_length_;
+    header.max_length = max_length_;
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+    std::vector<float> angles(ray_angles_.begin(), ray_angles_.end());
+    file.write(reinterpret_cast<const char*>(angles.data()), angles.size() * sizeof(float));
+
+    size_t samples = static_cast<size_t>(rows_) * cols_ * headings_ * ray_angles_.size();
+    file.write(reinterpret_cast<const char*>(data_), samples * sizeof(uint16_t));
+    return file.good();
+}
+
+bool PolicyTable::load(const std::string& path) {
+    clear();
+
+    if (!mapping_.open(path)) {
+        std::cerr << "Error: Could not map policy table: " << path << std::endl;
+        return false;
+    }
+    size_t size = mapping_.size();
+    if (size < sizeof(TableHeader)) {
+        std::cerr << "Error: Not a policy table: " << path << std::endl;
+        clear();
+        return false;
+    }
+
+    TableHeader header;
+    std::memcpy(&header, mapping_.data(), sizeof(header));
+    if (std::memcmp(header.magic, TABLE_MAGIC, sizeof(header.magic)) != 0 || header.version != TABLE_VERSION) {
+        std::cerr << "Error: Not a policy table (or unsupported version): " << path << std::endl;
+        clear();
+        return false;
+    }
+
+    size_t angles_size = header.rays * sizeof(float);
+    size_t samples = static_cast<size_t>(header.rows) * header.cols * header.headings * header.rays;
+    if (header.rays == 0 || header.rows <= 0 || header.cols <= 0 || header.headings <= 0 ||
+        size != sizeof(header) + angles_size + samples * sizeof(uint16_t)) {
+        std::cerr << "Error: Truncated policy table: " << path << std::endl;
+        clear();
+        return false;
+    }
+    if (header.cell_size <= 0 || header.min_length < 0 || header.max_length <= header.min_length ||
+        header.max_length > MAX_STORED_LENGTH) {
+        std::cerr << "Error: Corrupt policy table header: " << path << std::endl;
+        clear();
+        return false;
+    }
+
+    const uint8_t* bytes = mapping_.data();
+    std::vector<float> angles(header.rays);
+    std::memcpy(angles.data(), bytes + sizeof(header), angles_size);
+    ray_angles_.assign(angles.begin(), angles.end());
+
+    cell_size_ = header.cell_size;
+    cols_ = header.cols;
+    rows_ = header.rows;
+    headings_ = header.headings;
+    min_length_ = header.min_length;
+    max_length_ = header.max_length;
+    data_ = reinterpret_cast<const uint16_t*>(bytes + sizeof(header) + angles_size);
+    return true;
+}
+
+bool PolicyTable::lookup(float x, float y, double heading_deg, int* distances) const {
+    if (!isValid() || x < 0.0f || y < 0.0f || x >= cols_ * cell_size_ || y >= rows_ * cell_size_) {
+        return false;
+    }
+
+    // Samples sit at cell centres; clamp at the grid border
+    float fx = std::max(0.0f, std::min(cols_ - 1.0f, (x - cell_size_ * 0.5f) / cell_size_));
+    float fy = std::max(0.0f, std::min(rows_ - 1.0f, (y - cell_size_ * 0.5f) / cell_size_));
+    int x0 = static_cast<int>(fx);
+    int y0 = static_cast<int>(fy);
+    int x1 = std::min(cols_ - 1, x0 + 1);
+    int y1 = std::min(rows_ - 1, y0 + 1);
+    float wx = fx - x0;
+    float wy = fy - y0;
+
+    // Heading bins wrap around
+    double fh = std::fmod(heading_deg, 360.0);
+    if (fh < 0.0) {
+        fh += 360.0;
+    }
+    fh *= headings_ / 360.0;
+    int h0 = static_cast<int>(fh) % headings_;
+    int h1 = (h0 + 1) % headings_;
+    float wh = static_cast<float>(fh - std::floor(fh));
+
+    int rays = static_cast<int>(ray_angles_.size());
+    auto at = [&](int cx, int cy, int h) {
+        return data_ + ((static_cast<size_t>(cy) * cols_ + cx) * headings_ + h) * rays;
+    };
+    const uint16_t* corners[8] = {
+        at(x0, y0, h0), at(x1, y0, h0), at(x0, y1, h0), at(x1, y1, h0),
+        at(x0, y0, h1), at(x1, y0, h1), at(x0, y1, h1), at(x1, y1, h1)
+    };
+    float weights[8] = {
+        (1 - wx) * (1 - wy) * (1 - wh), wx * (1 - wy) * (1 - wh), (1 - wx) * wy * (1 - wh), wx * wy * (1 - wh),
+        (1 - wx) * (1 - wy) * wh,       wx * (1 - wy) * wh,       (1 - wx) * wy * wh,       wx * wy * wh
+    };
+
+    for (int r = 0; r < rays; ++r) {
+        float d = 0.0f;
+        for (int c = 0; c < 8; ++c) {
+            d += weights[c] * corners[c][r];
+        }
+        distances[r] = static_cast<int>(std::lround(d));
+    }
+    return true;
+}
+
+} // namespace rc_car
@@ -0,0 +1,256 @@
+/**
+ * @file racing_line.cpp
+ * @brief Minimum-curvature racing line, curvature-limited speed profile and its binary table format
+ */
+
+#include "racing_line.h"
+#include "mapped_file.h"
+#include <cmath>
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <cstring>
+
+namespace rc_car {
+
+namespace {
+
+// On-disk layout (little-endian): header followed by `count` entries
+struct TableHeader {
+    char magic[4];       // "RCRL"
+    uint16_t version;
+    uint16_t flags;      // bit 0: closed loop
+    uint32_t count;
+    float spacing;
+};
+
+struct TableEntry {
+    int16_t x;           // 1/16 px
+    int16_t y;           // 1/16 px
+    uint8_t speed;
+    uint8_t clearance;   // Whole pixels, saturated at 255
+};
+
+static_assert(sizeof(TableHeader) == 16, "Racing line header must stay 16 bytes");
+static_assert(sizeof(TableEntry) == 6, "Racing line entry must stay 6 bytes");
+
+constexpr char TABLE_MAGIC[4] = {'R', 'C', 'R', 'L'};
+constexpr uint16_t TABLE_VERSION = 1;
+constexpr uint16_t FLAG_CLOSED = 1;
+constexpr float FIXED_SCALE = 16.0f;
+constexpr float MAX_COORDINATE = 32767.0f / FIXED_SCALE;  // Largest coordinate an entry can hold (2047.9 px)
+constexpr int CURVATURE_STRIDE = 2;  // Waypoints either side used for the curvature estimate
+
+} // namespace
+
+void RacingLine::clear() {
+    line_.clear();
+    speed_.clear();
+    curvature_.clear();
+}
+
+bool RacingLine::optimise(const TrackCentreline& centreline, const RacingLineParams& params) {
+    clear();
+    if (!centreline.isValid()) {
+        return false;
+    }
+
+    const std::vector<cv::Point2f>& centre = centreline.waypoints();
+    const std::vector<float>& clearance = centreline.clearance();
+    int n = static_cast<int>(centre.size());
+    bool closed = centreline.isClosed();
+
+    // Each point may slide along the centreline normal within the corridor
+    std::vector<cv::Point2f> normal(n);
+    std::vector<float> width(n);
+    for (int i = 0; i < n; ++i) {
+        cv::Point2f t = centreline.tangent(i);
+        normal[i] = cv::Point2f(-t.y, t.x);
+        width[i] = std::max(0.0f, clearance[i] - params.margin);
+    }
+
+    // Elastic band: pull every point towards the midpoint of its neighbours (the discrete
+    // curvature), projected on the normal and clamped to the corridor. Ends of open tracks stay fixed.
+    std::vector<float> offset(n, 0.0f);
+    auto pointAt = [&](int i) { return centre[i] + normal[i] * offset[i]; };
+    int first = closed ? 0 : 1;
+    int last = closed ? n : n - 1;
+    for (int iter = 0; iter < params.iterations; ++iter) {
+        for (int i = first; i < last; ++i) {
+            cv::Point2f mid = (pointAt((i + n - 1) % n) + pointAt((i + 1) % n)) * 0.5f;
+            cv::Point2f pull = mid - pointAt(i);
+            float o = offset[i] + 0.5f * (pull.x * normal[i].x + pull.y * normal[i].y);
+            offset[i] = std::max(-width[i], std::min(width[i], o));
+        }
+    }
+
+    std::vector<cv::Point2f> raw(n);
+    std::vector<float> raw_clearance(n);
+    for (int i = 0; i < n; ++i) {
+        raw[i] = pointAt(i);
+        raw_clearance[i] = clearance[i] - std::abs(offset[i]);
+    }
+
+    // Keep the points evenly spaced so lookahead distances stay meaningful
+    std::vector<cv::Point2f> points;
+    std::vector<float> point_clearance;
+    TrackCentreline::resample(raw, raw_clearance, closed, centreline.spacing(), points, point_clearance);
+    if (points.size() < 2) {
+        return false;
+    }
+    line_.setWaypoints(points, point_clearance, closed, centreline.spacing());
+
+    computeCurvature();
+    computeSpeedProfile(params);
+    return isValid();
+}
+
+void RacingLine::computeCurvature() {
+    const std::vector<cv::Point2f>& p = line_.waypoints();
+    int n = static_cast<int>(p.size());
+    curvature_.assign(n, 0.0f);
+
+    for (int i = 0; i < n; ++i) {
+        int prev = line_.advance(i, CURVATURE_STRIDE, -1);
+        int next = line_.advance(i, CURVATURE_STRIDE, 1);
+        if (prev == i || next == i) {
+            continue;  // End of an open line
+        }
+        // Menger curvature of the triangle (prev, i, next); positive = turning right (image coordinates)
+        cv::Point2f a = p[i] - p[prev];
+        cv::Point2f b = p[next] - p[i];
+        cv::Point2f c = p[next] - p[prev];
+        float cross = a.x * b.y - a.y * b.x;
+        float denom = std::hypot(a.x, a.y) * std::hypot(b.x, b.y) * std::hypot(c.x, c.y);
+        curvature_[i] = denom > 0.0f ? 2.0f * cross / denom : 0.0f;
+    }
+}
+
+void RacingLine::computeSpeedProfile(const RacingLineParams& params) {
+    int n = static_cast<int>(line_.size());
+    float ds = line_.spacing();
+    float v_max = std::max(0.0f, std::min(255.0f, params.max_speed));
+    float v_min = std::max(0.0f, std::min(v_max, params.min_speed));
+
+    // Lateral grip limit: v^2 / r <= v_max^2 / full_speed_radius
+    std::vector<float> v(n);
+    for (int i = 0; i < n; ++i) {
+        float k = std::abs(curvature_[i]);
+        float limit = v_max;
+        if (k > 0.0f && params.full_speed_radius > 0.0f) {
+            limit = v_max * std::sqrt(std::min(1.0f, 1.0f / (k * params.full_speed_radius)));
+        }
+        v[i] = std::max(v_min, limit);
+    }
+    if (!line_.isClosed()) {
+        v[0] = v_min;
+        v[n - 1] = v_min;
+    }
+
+    // Acceleration (forward) and braking (backward) passes; loops need a second lap to settle the wrap
+    int laps = line_.isClosed() ? 2 : 1;
+    for (int lap = 0; lap < laps; ++lap) {
+        for (int i = 1; i < n + (line_.isClosed() ? 1 : 0); ++i) {
+            int cur = i % n;
+            v[cur] = std::min(v[cur], std::sqrt(v[i - 1] * v[i - 1] + 2.0f * params.accel * ds));
+        }
+    }
+    for (int lap = 0; lap < laps; ++lap) {
+        for (int i = n - 2 + (line_.isClosed() ? 1 : 0); i >= 0; --i) {
+            int next = (i + 1) % n;
+            v[i] = std::min(v[i], std::sqrt(v[next] * v[next] + 2.0f * params.brake * ds));
+        }
+    }
+
+    speed_.resize(n);
+    for (int i = 0; i < n; ++i) {
+        speed_[i] = static_cast<uint8_t>(std::lround(std::max(0.0f, std::min(255.0f, v[i]))));
+    }
+}
+
+bool RacingLine::save(const std::string& path) const {
+    if (!isValid()) {
+        std::cerr << "Error: No racing line to save" << std::endl;
+        return false;
+    }
+
+    // Entries hold 1/16 px in 16 bits: refuse a line that would wrap rather than write a wrong one
+    for (const cv::Point2f& p : line_.waypoints()) {
+        if (p.x < -MAX_COORDINATE || p.x > MAX_COORDINATE || p.y < -MAX_COORDINATE || p.y > MAX_COORDINATE) {
+            std::cerr << "Error: Racing line exceeds the table's " << MAX_COORDINATE
+                      << " px coordinate range, not saved: " << path << std::endl;
+            return false;
+        }
+    }
+
+    std::ofstream file(path, std::ios::binary);
+    if (!file.is_open()) {
+        std::cerr << "Error: Could not write racing line: " << path << std::endl;
+        return false;
+    }
+
+    TableHeader header;
+    std::memcpy(header.magic, TABLE_MAGIC, sizeof(header.magic));
+    header.version = TABLE_VERSION;
+    header.flags = line_.isClosed() ? FLAG_CLOSED : 0;
+    header.count = static_cast<uint32_t>(line_.size());
+    header.spacing = line_.spacing();
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+    std::vector<TableEntry> entries(line_.size());
+    for (size_t i = 0; i < entries.size(); ++i) {
+        const cv::Point2f& p = line_.waypoints()[i];
+        entries[i].x = static_cast<int16_t>(std::lround(p.x * FIXED_SCALE));
+        entries[i].y = static_cast<int16_t>(std::lround(p.y * FIXED_SCALE));
+        entries[i].speed = speed_[i];
+        entries[i].clearance = static_cast<uint8_t>(std::max(0.0f, std::min(255.0f, line_.clearance()[i])));
+    }
+    file.write(reinterpret_cast<const char*>(entries.data()), entries.size() * sizeof(TableEntry));
+    return file.good();
+}
+
+bool RacingLine::load(const std::string& path) {
+    clear();
+    MappedFile file;
+    if (!file.open(path)) {
+        std::cerr << "Error: Could not open racing line: " << path << std::endl;
+        return false;
+    }
+
+    TableHeader header;
+    if (file.size() < sizeof(header) ||
+        std::memcmp(file.data(), TABLE_MAGIC, sizeof(header.magic)) != 0) {
+        std::cerr << "Error: Not a racing line table: " << path << std::endl;
+        return false;
+    }
+    std::memcpy(&header, file.data(), sizeof(header));
+    if (header.version != TABLE_VERSION) {
+        std::cerr << "Error: Unsupported racing line version " << header.version << " in " << path << std::endl;
+        return false;
+    }
+    if (header.count < 2 || file.size() != sizeof(header) + header.count * sizeof(TableEntry)) {
+        std::cerr << "Error: Truncated racing line table: " << path << std::endl;
+        return false;
+    }
+    if (!(header.spacing > 0.0f) || !std::isfinite(header.spacing)) {
+        std::cerr << "Error: Corrupt racing line header: " << path << std::endl;
+        return false;
+    }
+
+    std::vector<TableEntry> entries(header.count);
+    std::memcpy(entries.data(), file.data() + sizeof(header), entries.size() * sizeof(TableEntry));
+
+    std::vector<cv::Point2f> points(header.count);
+    std::vector<float> clearance(header.count);
+    speed_.resize(header.count);
+    for (size_t i = 0; i < entries.size(); ++i) {
+        points[i] = cv::Point2f(entries[i].x / FIXED_SCALE, entries[i].y / FIXED_SCALE);
+        clearance[i] = entries[i].clearance;
+        speed_[i] = entries[i].speed;
+    }
+    line_.setWaypoints(points, clearance, (header.flags & FLAG_CLOSED) != 0, header.spacing);
+    computeCurvature();
+    return isValid();
+}
+
+} // namespace rc_car
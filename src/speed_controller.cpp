@@ -0,0 +1,185 @@
+/**
+ * @file speed_controller.cpp
+ * @brief Closed-loop speed control on the tracked velocity with an online command -> velocity map
+ */
+
+#include "speed_controller.h"
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+namespace rc_car {
+
+namespace {
+
+double seconds(std::chrono::steady_clock::duration d) {
+    return std::chrono::duration<double>(d).count();
+}
+
+} // namespace
+
+SpeedController::SpeedController()
+    : mode_(SpeedMode::OPEN_LOOP), has_position_(false), last_x_(0.0), last_y_(0.0),
+      has_velocity_(false), velocity_(0.0), sum_w_(0.0), sum_c_(0.0), sum_v_(0.0), sum_cc_(0.0), sum_cv_(0.0), scale_(1.0),
+      warming_up_(true), warmup_started_(false), warmup_extended_(false), warmup_base_(0), held_command_(-1),
+      integral_(0.0), has_update_(false) {
+}
+
+void SpeedController::reset() {
+    has_position_ = false;
+    has_velocity_ = false;
+    velocity_ = 0.0;
+    held_command_ = -1;
+    integral_ = 0.0;
+    has_update_ = false;
+}
+
+void SpeedController::observe(double x, double y, std::chrono::steady_clock::time_point time) {
+    if (has_position_) {
+        double dt = seconds(time - last_observed_);
+        if (dt <= 0.0) {
+            return;  // Same frame seen twice
+        }
+        if (dt > STALE_S) {
+            has_velocity_ = false;
+        } else {
+            double raw = std::hypot(x - last_x_, y - last_y_) / dt;
+            if (!has_velocity_) {
+                velocity_ = raw;
+                has_velocity_ = true;
+            } else {
+                velocity_ += dt / (params_.filter_seconds + dt) * (raw - velocity_);
+            }
+        }
+    }
+    has_position_ = true;
+    last_x_ = x;
+    last_y_ = y;
+    last_observed_ = time;
+}
+
+void SpeedController::sample(int command, std::chrono::steady_clock::time_point now) {
+    // Only steady state is sampled: the command has been held long enough for the car to settle
+    if (std::abs(command - held_command_) > 1) {
+        held_command_ = command;
+        held_since_ = now;
+        return;
+    }
+    if (!has_velocity_ || seconds(now - last_observed_) > STALE_S || seconds(now - held_since_) < SETTLE_S) {
+        return;
+    }
+    double c = command;
+    double v = velocity_;
+    double decay = params_.forgetting;
+    if (!warming_up_) {
+        // Closed loop sits at one operating point, which cannot pin down a slope: only the
+        // overall scale of the warm-up map is tracked (battery sag scales the whole curve).
+        // A car held against a wall (v near 0) or a tracking glitch says nothing about the
+        // battery, so ratios outside the plausible range are skipped rather than learned.
+        double expected = nominal_.velocity(c);
+        double ratio = expected > 0.0 ? v / expected : 0.0;
+        if (ratio >= MIN_SCALE && ratio <= MAX_SCALE) {
+            scale_ += (1.0 - decay) * (ratio - scale_);
+            scale_ = std::max(MIN_SCALE, std::min(MAX_SCALE, scale_));
+            map_.gain = scale_ * nominal_.gain;
+            map_.offset = scale_ * nominal_.offset;
+        }
+        return;
+    }
+    sum_w_ = sum_w_ * decay + 1.0;
+    sum_c_ = sum_c_ * decay + c;
+    sum_v_ = sum_v_ * decay + v;
+    sum_cc_ = sum_cc_ * decay + c * c;
+    sum_cv_ = sum_cv_ * decay + c * v;
+}
+
+bool SpeedController::fit() {
+    if (sum_w_ <= 0.0) {
+        return false;
+    }
+    double det = sum_w_ * sum_cc_ - sum_c_ * sum_c_;
+    if (det < MIN_SPREAD * MIN_SPREAD * sum_w_ * sum_w_) {
+        return false;  // All samples at (nearly) one command: the slope is unknown
+    }
+    double gain = (sum_w_ * sum_cv_ - sum_c_ * sum_v_) / det;
+    if (gain <= 0.0) {
+        return false;
+    }
+    map_.gain = gain;
+    map_.offset = (sum_v_ - gain * sum_c_) / sum_w_;
+    map_.valid = true;
+    return true;
+}
+
+int SpeedController::hold(int command, std::chrono::steady_clock::time_point now) {
+    command = std::max(0, std::min(255, command));
+    sample(command, now);
+    return command;
+}
+
+int SpeedController::update(int requested_speed, std::chrono::steady_clock::time_point now) {
+    if (mode_ == SpeedMode::OPEN_LOOP) {
+        return requested_speed;
+    }
+    double dt = has_update_ ? std::min(0.1, seconds(now - last_update_)) : 0.0;
+    has_update_ = true;
+    last_update_ = now;
+
+    if (requested_speed <= 0) {
+        integral_ = 0.0;
+        held_command_ = -1;
+        return 0;
+    }
+
+    if (warming_up_) {
+        // Open loop on a fixed schedule: a square-wave dither around one command. The guidance
+        // speed is not followed, since in histogram and racing-line modes it changes nearly every
+        // frame and no command would be held long enough to sample. The clock only starts once
+        // the car moves.
+        if (!warmup_started_) {
+            if (!has_velocity_) {
+                return requested_speed;
+            }
+            warmup_started_ = true;
+            warmup_start_ = now;
+            warmup_base_ = params_.warmup_command > 0 ? params_.warmup_command : requested_speed;
+        }
+        double elapsed = seconds(now - warmup_start_);
+        bool high = static_cast<long>(elapsed / DITHER_PERIOD_S) % 2 == 0;
+        int command = hold(warmup_base_ + (high ? params_.warmup_dither : -params_.warmup_dither), now);
+        if (elapsed >= params_.warmup_seconds) {
+            if (fit()) {
+                warming_up_ = false;
+                nominal_ = map_;
+                scale_ = 1.0;
+                std::cout << "Speed map: velocity = " << map_.gain << " * command + " << map_.offset << std::endl;
+            } else if (!warmup_extended_) {
+                warmup_extended_ = true;
+                std::cerr << "Warning: Speed map not identifiable yet, extending warm-up" << std::endl;
+            }
+        }
+        return command;
+    }
+
+    double target = params_.target_scale > 0.0 ? requested_speed * params_.target_scale
+                                               : std::max(0.0, nominal_.velocity(requested_speed));
+    double feed_forward = map_.command(target);
+    int ceiling = std::max(0, std::min(255, params_.max_command));
+
+    if (!has_velocity_ || seconds(now - last_observed_) > STALE_S) {
+        // No usable measurement: feed-forward alone, PI held
+        return hold(static_cast<int>(std::lround(std::max(0.0, std::min<double>(ceiling, feed_forward)))), now);
+    }
+
+    // PI in command units (error divided by the map gain), conditional integration against windup
+    double error = (target - velocity_) / map_.gain;
+    double output = feed_forward + params_.kp * error + integral_;
+    bool saturated = (output >= ceiling && error > 0.0) || (output <= 0.0 && error < 0.0);
+    if (!saturated) {
+        integral_ += params_.ki * error * dt;
+        output = feed_forward + params_.kp * error + integral_;
+    }
+    return hold(static_cast<int>(std::lround(std::max(0.0, std::min<double>(ceiling, output)))), now);
+}
+
+} // namespace rc_car
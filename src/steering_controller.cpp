@@ -0,0 +1,261 @@
+/**
+ * @file steering_controller.cpp
+ * @brief Continuous steering: PID and budgeted, warm-started MPC over a kinematic bicycle model
+ */
+
+#include "steering_controller.h"
+#include <algorithm>
+#include <cmath>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+namespace rc_car {
+
+namespace {
+
+constexpr double DEG = 180.0 / M_PI;
+constexpr double MIN_SPEED = 1.0;  // px per cycle; a stationary car still gets a plan
+
+double clampUnit(double value) {
+    return std::max(-1.0, std::min(1.0, value));
+}
+
+} // namespace
+
+SteeringController::SteeringController()
+    : mode_(SteeringMode::BANG_BANG), integral_(0.0), prev_error_(0.0), prev_output_(0.0),
+      primed_(false), retargeted_(false) {
+    setParams(SteeringParams());
+}
+
+void SteeringController::setParams(const SteeringParams& params) {
+    params_ = params;
+    params_.horizon = std::max(1, params_.horizon);
+    params_.budget_us = std::max(0, params_.budget_us);
+    params_.full_lock_angle = std::max(1.0, std::min(89.0, params_.full_lock_angle));
+    params_.wheelbase = std::max(1.0, params_.wheelbase);
+    trial_.resize(params_.horizon);
+    gradient_.resize(params_.horizon);
+    direction_.resize(params_.horizon);
+    hessian_.resize(params_.horizon * params_.horizon);
+    sens_heading_.resize(params_.horizon);
+    sens_offset_.resize(params_.horizon);
+    heading_.resize(params_.horizon + 1);
+    offset_.resize(params_.horizon + 1);
+    reset();
+}
+
+void SteeringController::reset() {
+    integral_ = 0.0;
+    prev_error_ = 0.0;
+    prev_output_ = 0.0;
+    primed_ = false;
+    retargeted_ = false;
+    plan_.assign(params_.horizon, 0.0);
+}
+
+double SteeringController::update(double heading_error, double cross_track_error, double speed) {
+    auto now = std::chrono::steady_clock::now();
+    if (primed_ && std::chrono::duration<double>(now - last_update_).count() > RESET_GAP_S) {
+        reset();
+    }
+    last_update_ = now;
+    ++stats_.cycles;
+
+    double output = (mode_ == SteeringMode::MPC)
+        ? updateMpc(heading_error, cross_track_error, std::max(MIN_SPEED, speed))
+        : updatePid(heading_error, cross_track_error);
+    prev_output_ = output;
+    primed_ = true;
+    retargeted_ = false;
+    return output;
+}
+
+double SteeringController::updatePid(double heading_error, double cross_track_error) {
+    double error = heading_error + params_.cross_track_gain * cross_track_error;
+    double derivative = primed_ && !retargeted_ ? error - prev_error_ : 0.0;
+    prev_error_ = error;
+
+    // Conditional integration: hold the integral while saturated in the direction of the error
+    double output = params_.kp * error + params_.ki * integral_ + params_.kd * derivative;
+    if (std::abs(output) < 1.0 || (output > 0.0) != (error > 0.0)) {
+        integral_ += error;
+        output = params_.kp * error + params_.ki * integral_ + params_.kd * derivative;
+    }
+    return clampUnit(output);
+}
+
+double SteeringController::planCost(double heading_error, double cross_track_error, double speed,
+                                     const std::vector<double>& plan) {
+    const int n = params_.horizon;
+    const double lock = params_.full_lock_angle / DEG;
+    const double yaw = speed / params_.wheelbase * DEG;  // Heading change (deg) per unit tan(steer)
+
+    // Roll the model forward: steering right turns the car toward a target on the right
+    // (heading error shrinks); a car heading left of the target drifts away from it sideways.
+    heading_[0] = heading_error;
+    offset_[0] = cross_track_error;
+    double cost = 0.0;
+    double previous = prev_output_;
+    for (int k = 0; k < n; ++k) {
+        heading_[k + 1] = heading_[k] - yaw * std::tan(plan[k] * lock);
+        offset_[k + 1] = offset_[k] + speed * std::sin(heading_[k] / DEG);
+        double rate = plan[k] - previous;
+        cost += params_.heading_weight * heading_[k + 1] * heading_[k + 1] +
+                params_.cross_track_weight * offset_[k + 1] * offset_[k + 1] +
+                params_.effort_weight * plan[k] * plan[k] + params_.rate_weight * rate * rate;
+        previous = plan[k];
+    }
+    return cost;
+}
+
+bool SteeringController::newtonStep(double speed) {
+    const int n = params_.horizon;
+    const double lock = params_.full_lock_angle / DEG;
+    const double yaw = speed / params_.wheelbase * DEG;
+    std::fill(hessian_.begin(), hessian_.end(), 0.0);
+    std::fill(gradient_.begin(), gradient_.end(), 0.0);
+
+    // Steering terms
+    for (int k = 0; k < n; ++k) {
+        double before = (k > 0) ? plan_[k - 1] : prev_output_;
+        double rate = plan_[k] - before;
+        hessian_[k * n + k] += params_.effort_weight + params_.rate_weight;
+        gradient_[k] += params_.effort_weight * plan_[k] + params_.rate_weight * rate;
+        if (k > 0) {
+            hessian_[(k - 1) * n + (k - 1)] += params_.rate_weight;
+            hessian_[k * n + (k - 1)] -= params_.rate_weight;
+            hessian_[(k - 1) * n + k] -= params_.rate_weight;
+            gradient_[k - 1] -= params_.rate_weight * rate;
+        }
+    }
+
+    // State terms (Gauss-Newton): sensitivities of heading and offset at step j to every u_k.
+    // The model is linear in tan(u), so heading at j depends on u_k (k < j) by -yaw * lock / cos^2.
+    std::fill(sens_offset_.begin(), sens_offset_.end(), 0.0);
+    std::fill(sens_heading_.begin(), sens_heading_.end(), 0.0);
+    for (int j = 1; j <= n; ++j) {
+        // offset[j] = offset[j-1] + v sin(heading[j-1]): uses heading sensitivities of step j-1
+        double drift = speed * std::cos(heading_[j - 1] / DEG) / DEG;
+        for (int k = 0; k < j - 1; ++k) {
+            sens_offset_[k] += drift * sens_heading_[k];
+        }
+        double c = std::cos(plan_[j - 1] * lock);
+        sens_heading_[j - 1] = -yaw * lock / (c * c);
+
+        for (int a = 0; a < j; ++a) {
+            gradient_[a] += params_.heading_weight * heading_[j] * sens_heading_[a] +
+                            params_.cross_track_weight * offset_[j] * sens_offset_[a];
+            for (int b = 0; b < j; ++b) {
+                hessian_[a * n + b] += params_.heading_weight * sens_heading_[a] * sens_heading_[b] +
+                                       params_.cross_track_weight * sens_offset_[a] * sens_offset_[b];
+            }
+        }
+    }
+
+    // Steering pinned at a limit with the gradient pushing outwards stays there this step
+    for (int k = 0; k < n; ++k) {
+        if ((plan_[k] >= 1.0 && gradient_[k] < 0.0) || (plan_[k] <= -1.0 && gradient_[k] > 0.0)) {
+            for (int m = 0; m < n; ++m) {
+                hessian_[k * n + m] = 0.0;
+                hessian_[m * n + k] = 0.0;
+            }
+            hessian_[k * n + k] = 1.0;
+            gradient_[k] = 0.0;
+        }
+    }
+
+    // Cholesky solve H d = -g in place (H is positive definite: effort_weight > 0)
+    for (int r = 0; r < n; ++r) {
+        for (int c = 0; c <= r; ++c) {
+            double sum = hessian_[r * n + c];
+            for (int m = 0; m < c; ++m) {
+                sum -= hessian_[r * n + m] * hessian_[c * n + m];
+            }
+            if (r == c) {
+                if (sum <= 0.0) {
+                    return false;
+                }
+                hessian_[r * n + r] = std::sqrt(sum);
+            } else {
+                hessian_[r * n + c] = sum / hessian_[c * n + c];
+            }
+        }
+    }
+    for (int r = 0; r < n; ++r) {
+        double sum = -gradient_[r];
+        for (int m = 0; m < r; ++m) {
+            sum -= hessian_[r * n + m] * direction_[m];
+        }
+        direction_[r] = sum / hessian_[r * n + r];
+    }
+    for (int r = n - 1; r >= 0; --r) {
+        double sum = direction_[r];
+        for (int m = r + 1; m < n; ++m) {
+            sum -= hessian_[m * n + r] * direction_[m];
+        }
+        direction_[r] = sum / hessian_[r * n + r];
+    }
+    return true;
+}
+
+double SteeringController::updateMpc(double heading_error, double cross_track_error, double speed) {
+    auto start = std::chrono::steady_clock::now();
+    const auto budget = std::chrono::microseconds(params_.budget_us);
+    const int n = params_.horizon;
+
+    // Warm start: last cycle's plan, shifted by one step
+    if (primed_ && n > 1) {
+        std::rotate(plan_.begin(), plan_.begin() + 1, plan_.end());
+        plan_[n - 1] = plan_[n - 2];
+    }
+
+    // Projected Gauss-Newton with backtracking; the plan only ever improves, so stopping
+    // at the budget after any iteration leaves a usable plan
+    double cost = planCost(heading_error, cross_track_error, speed, plan_);
+    int iterations = 0;
+    bool stopped = false;
+    while (iterations < MAX_ITERATIONS) {
+        if (std::chrono::steady_clock::now() - start >= budget) {
+            stopped = true;
+            break;
+        }
+        ++iterations;
+        if (!newtonStep(speed)) {
+            break;
+        }
+
+        bool improved = false;
+        double moved = 0.0;
+        for (double alpha = 1.0; alpha > 1e-3 && !improved; alpha *= 0.5) {
+            moved = 0.0;
+            for (int k = 0; k < n; ++k) {
+                trial_[k] = clampUnit(plan_[k] + alpha * direction_[k]);
+                moved = std::max(moved, std::abs(trial_[k] - plan_[k]));
+            }
+            double next = planCost(heading_error, cross_track_error, speed, trial_);
+            if (next < cost) {
+                cost = next;
+                plan_.swap(trial_);
+                improved = true;
+            }
+        }
+        // Leave heading_/offset_ describing plan_ for the next linearisation
+        planCost(heading_error, cross_track_error, speed, plan_);
+        if (!improved || moved < CONVERGED) {
+            break;
+        }
+    }
+
+    stats_.iterations += iterations;
+    if (stopped) {
+        ++stats_.budget_hits;
+    }
+    double elapsed = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+    stats_.max_solve_us = std::max(stats_.max_solve_us, elapsed);
+    return plan_[0];
+}
+
+} // namespace rc_car
@@ -0,0 +1,102 @@
+/**
+ * @file tiled_boundary_mask.cpp
+ * @brief Dirty-tile incremental thresholding of the boundary mask
+ */
+
+#include "tiled_boundary_mask.h"
+#include <algorithm>
+
+namespace rc_car {
+
+TiledBoundaryMask::TiledBoundaryMask()
+    : tile_size_(64), diff_threshold_(12), black_threshold_(-1) {
+}
+
+void TiledBoundaryMask::toGray(const cv::Mat& frame, cv::Mat& gray) const {
+    if (frame.channels() == 3) {
+        cv::cvtColor(frame, gray, cv::COLOR_BGR2GRAY);
+    } else if (frame.channels() == 4) {
+        cv::cvtColor(frame, gray, cv::COLOR_BGRA2GRAY);
+    } else {
+        gray = frame;
+    }
+}
+
+void TiledBoundaryMask::thresholdRegion(const cv::Mat& frame, const cv::Rect& region) {
+    // Same rule as BoundaryDetection::buildBoundaryMask: boundary where gray < black_threshold
+    toGray(frame(region), tile_gray_);
+    cv::threshold(tile_gray_, tile_mask_, black_threshold_ - 1, 255, cv::THRESH_BINARY_INV);
+    cv::Mat target = mask_(region);
+    tile_mask_.copyTo(target);
+}
+
+void TiledBoundaryMask::rebuild(const cv::Mat& frame, const cv::Rect& exclude) {
+    mask_.create(frame.rows, frame.cols, CV_8UC1);
+    cv::Rect whole(0, 0, frame.cols, frame.rows);
+    thresholdRegion(frame, whole);
+
+    // The car is dark too; keep it out of the mask
+    cv::Rect car = exclude & whole;
+    if (car.area() > 0) {
+        mask_(car).setTo(cv::Scalar(0));
+    }
+
+    sample_.copyTo(reference_);
+    dirty_.assign(1, whole);
+}
+
+const std::vector<cv::Rect>& TiledBoundaryMask::update(const cv::Mat& frame, int black_threshold,
+                                                      const cv::Rect& exclude) {
+    dirty_.clear();
+    if (frame.empty()) {
+        return dirty_;
+    }
+
+    // Cheap change detector: nearest-neighbour downsample, then gray
+    cv::resize(frame, small_, cv::Size((frame.cols + SAMPLE_STEP - 1) / SAMPLE_STEP,
+                                       (frame.rows + SAMPLE_STEP - 1) / SAMPLE_STEP),
+               0, 0, cv::INTER_NEAREST);
+    toGray(small_, sample_);
+
+    if (mask_.empty() || mask_.size() != frame.size() || black_threshold != black_threshold_ ||
+        reference_.size() != sample_.size()) {
+        black_threshold_ = black_threshold;
+        rebuild(frame, exclude);
+        return dirty_;
+    }
+
+    cv::absdiff(sample_, reference_, diff_);
+
+    int sample_tile = tile_size_ / SAMPLE_STEP;
+    for (int ty = 0; ty < frame.rows; ty += tile_size_) {
+        for (int tx = 0; tx < frame.cols; tx += tile_size_) {
+            cv::Rect tile(tx, ty, std::min(tile_size_, frame.cols - tx), std::min(tile_size_, frame.rows - ty));
+            if ((tile & exclude).area() > 0) {
+                continue;
+            }
+
+            cv::Rect samples(tx / SAMPLE_STEP, ty / SAMPLE_STEP,
+                             std::min(sample_tile, diff_.cols - tx / SAMPLE_STEP),
+                             std::min(sample_tile, diff_.rows - ty / SAMPLE_STEP));
+            int max_diff = 0;
+            for (int y = samples.y; y < samples.y + samples.height && max_diff <= diff_threshold_; ++y) {
+                const uchar* row = diff_.ptr<uchar>(y);
+                for (int x = samples.x; x < samples.x + samples.width; ++x) {
+                    max_diff = std::max(max_diff, static_cast<int>(row[x]));
+                }
+            }
+            if (max_diff <= diff_threshold_) {
+                continue;
+            }
+
+            // Re-threshold at full resolution and remember what this tile now reflects
+            thresholdRegion(frame, tile);
+            cv::Mat reference_tile = reference_(samples);
+            sample_(samples).copyTo(reference_tile);
+            dirty_.push_back(tile);
+        }
+    }
+    return dirty_;
+}
+
+} // namespace rc_car
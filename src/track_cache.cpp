@@ -0,0 +1,80 @@
+/**
+ * @file track_cache.cpp
+ * @brief Hash-keyed on-disk cache of derived track artefacts
+ */
+
+#include "track_cache.h"
+#include <atomic>
+#include <cstdio>
+#include <filesystem>
+#include <iostream>
+#include <sstream>
+#include <iomanip>
+#include <unistd.h>
+
+namespace rc_car {
+
+TrackCache::TrackCache() : image_hash_(FNV_OFFSET_BASIS), has_image_(false) {
+}
+
+uint64_t TrackCache::hash(const void* data, size_t size, uint64_t seed) {
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    uint64_t h = seed;
+    for (size_t i = 0; i < size; ++i) {
+        h ^= bytes[i];
+        h *= FNV_PRIME;
+    }
+    return h;
+}
+
+void TrackCache::setSourceImage(const cv::Mat& image) {
+    if (image.empty()) {
+        has_image_ = false;
+        return;
+    }
+
+    // Geometry and type first, then the pixels row by row (rows may be padded)
+    int shape[3] = {image.rows, image.cols, image.type()};
+    uint64_t h = hash(shape, sizeof(shape));
+    size_t row_bytes = image.cols * image.elemSize();
+    for (int y = 0; y < image.rows; ++y) {
+        h = hash(image.ptr(y), row_bytes, h);
+    }
+    image_hash_ = h;
+    has_image_ = true;
+}
+
+std::string TrackCache::path(const std::string& name, const std::string& params, const std::string& extension) const {
+    if (!isEnabled()) {
+        return "";
+    }
+    uint64_t key = hash(params.data(), params.size(), image_hash_);
+    std::ostringstream file;
+    file << name << "-" << std::hex << std::setw(16) << std::setfill('0') << key << extension;
+    return (std::filesystem::path(directory_) / file.str()).string();
+}
+
+bool TrackCache::store(const std::string& path, const std::function<bool(const std::string&)>& save) const {
+    if (path.empty()) {
+        return false;
+    }
+
+    std::error_code error;
+    std::filesystem::create_directories(std::filesystem::path(path).parent_path(), error);
+    if (error) {
+        std::cerr << "Warning: Could not create cache directory for " << path << ": " << error.message() << std::endl;
+        return false;
+    }
+
+    // Unique per writer, so processes or threads storing the same entry never share a file
+    static std::atomic<unsigned> counter(0);
+    std::string temporary = path + "." + std::to_string(getpid()) + "-" + std::to_string(counter++) + ".tmp";
+    if (!save(temporary) || std::rename(temporary.c_str(), path.c_str()) != 0) {
+        std::remove(temporary.c_str());
+        std::cerr << "Warning: Could not write cache entry " << path << std::endl;
+        return false;
+    }
+    return true;
+}
+
+} // namespace rc_car
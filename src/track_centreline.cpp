@@ -0,0 +1,561 @@
+/**
+ * @file track_centreline.cpp
+ * @brief Centreline (skeleton) extraction of the drivable track region and nearest-waypoint index
+ */
+
+#include "track_centreline.h"
+#include "mapped_file.h"
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <algorithm>
+#include <deque>
+#include <limits>
+
+namespace rc_car {
+
+namespace {
+
+constexpr int GRID_CELL_SIZE = 32;    // Pixels per spatial index cell
+constexpr int SMOOTHING_RADIUS = 2;   // Waypoints averaged on each side after resampling
+
+// 8-neighbourhood, 4-connected neighbours first so traces prefer straight steps
+const int NEIGHBOUR_DX[8] = {0, 1, 0, -1, 1, 1, -1, -1};
+const int NEIGHBOUR_DY[8] = {-1, 0, 1, 0, -1, 1, 1, -1};
+
+// Zhang-Suen thinning of a 0/1 image with a zero border
+void thin(cv::Mat& img) {
+    cv::Mat marker(img.size(), CV_8UC1);
+    bool changed = true;
+
+    while (changed) {
+        changed = false;
+        for (int pass = 0; pass < 2; ++pass) {
+            marker.setTo(cv::Scalar(0));
+            for (int y = 1; y < img.rows - 1; ++y) {
+                const uchar* above = img.ptr<uchar>(y - 1);
+                const uchar* row = img.ptr<uchar>(y);
+                const uchar* below = img.ptr<uchar>(y + 1);
+                uchar* out = marker.ptr<uchar>(y);
+                for (int x = 1; x < img.cols - 1; ++x) {
+                    if (!row[x]) {
+                        continue;
+                    }
+                    int p2 = above[x], p3 = above[x + 1], p4 = row[x + 1], p5 = below[x + 1];
+                    int p6 = below[x], p7 = below[x - 1], p8 = row[x - 1], p9 = above[x - 1];
+
+                    int transitions = (!p2 && p3) + (!p3 && p4) + (!p4 && p5) + (!p5 && p6) +
+                                      (!p6 && p7) + (!p7 && p8) + (!p8 && p9) + (!p9 && p2);
+                    int neighbours = p2 + p3 + p4 + p5 + p6 + p7 + p8 + p9;
+                    int m1 = pass == 0 ? (p2 * p4 * p6) : (p2 * p4 * p8);
+                    int m2 = pass == 0 ? (p4 * p6 * p8) : (p2 * p6 * p8);
+
+                    if (transitions == 1 && neighbours >= 2 && neighbours <= 6 && m1 == 0 && m2 == 0) {
+                        out[x] = 1;
+                    }
+                }
+            }
+            for (int y = 1; y < img.rows - 1; ++y) {
+                uchar* row = img.ptr<uchar>(y);
+                const uchar* out = marker.ptr<uchar>(y);
+                for (int x = 1; x < img.cols - 1; ++x) {
+                    if (out[x]) {
+                        row[x] = 0;
+                        changed = true;
+                    }
+                }
+            }
+        }
+    }
+}
+
+int countNeighbours(const cv::Mat& img, int x, int y) {
+    int count = 0;
+    for (int k = 0; k < 8; ++k) {
+        count += img.at<uchar>(y + NEIGHBOUR_DY[k], x + NEIGHBOUR_DX[k]) ? 1 : 0;
+    }
+    return count;
+}
+
+// Repeatedly strip end points so only closed loops of the skeleton remain
+cv::Mat pruneToLoops(const cv::Mat& skeleton) {
+    cv::Mat loops = skeleton.clone();
+    std::deque<cv::Point> ends;
+    for (int y = 1; y < loops.rows - 1; ++y) {
+        for (int x = 1; x < loops.cols - 1; ++x) {
+            if (loops.at<uchar>(y, x) && countNeighbours(loops, x, y) <= 1) {
+                ends.emplace_back(x, y);
+            }
+        }
+    }
+
+    while (!ends.empty()) {
+        cv::Point p = ends.front();
+        ends.pop_front();
+        if (!loops.at<uchar>(p.y, p.x)) {
+            continue;
+        }
+        loops.at<uchar>(p.y, p.x) = 0;
+        for (int k = 0; k < 8; ++k) {
+            int nx = p.x + NEIGHBOUR_DX[k];
+            int ny = p.y + NEIGHBOUR_DY[k];
+            if (loops.at<uchar>(ny, nx) && countNeighbours(loops, nx, ny) <= 1) {
+                ends.emplace_back(nx, ny);
+            }
+        }
+    }
+    return loops;
+}
+
+cv::Point nearestOn(const cv::Mat& img, const cv::Point& target) {
+    cv::Point best(-1, -1);
+    long best_dist = std::numeric_limits<long>::max();
+    for (int y = 0; y < img.rows; ++y) {
+        const uchar* row = img.ptr<uchar>(y);
+        for (int x = 0; x < img.cols; ++x) {
+            if (row[x]) {
+                long d = static_cast<long>(x - target.x) * (x - target.x) +
+                         static_cast<long>(y - target.y) * (y - target.y);
+                if (d < best_dist) {
+                    best_dist = d;
+                    best = cv::Point(x, y);
+                }
+            }
+        }
+    }
+    return best;
+}
+
+// Walk a loop of the skeleton from `start` until it closes (or dead-ends)
+std::vector<cv::Point> traceLoop(const cv::Mat& loops, const cv::Point& start, bool& closed) {
+    cv::Mat visited = cv::Mat::zeros(loops.size(), CV_8UC1);
+    std::vector<cv::Point> path;
+    cv::Point current = start;
+    closed = false;
+
+    while (true) {
+        path.push_back(current);
+        visited.at<uchar>(current.y, current.x) = 1;
+
+        cv::Point next(-1, -1);
+        bool start_adjacent = false;
+        for (int k = 0; k < 8; ++k) {
+            cv::Point n(current.x + NEIGHBOUR_DX[k], current.y + NEIGHBOUR_DY[k]);
+            if (!loops.at<uchar>(n.y, n.x)) {
+                continue;
+            }
+            if (n == start) {
+                start_adjacent = true;
+            }
+            if (!visited.at<uchar>(n.y, n.x) && next.x < 0) {
+                next = n;
+            }
+        }
+
+        if (next.x < 0) {
+            closed = start_adjacent && path.size() > 2;
+            break;
+        }
+        current = next;
+    }
+    return path;
+}
+
+// Longest shortest-path through an open (tree-like) skeleton
+std::vector<cv::Point> traceOpen(const cv::Mat& skeleton, const cv::Point& start) {
+    auto bfs = [&skeleton](const cv::Point& from, cv::Mat& parent) {
+        parent = cv::Mat(skeleton.size(), CV_32SC1, cv::Scalar(-1));
+        std::deque<cv::Point> queue{from};
+        parent.at<int>(from.y, from.x) = from.y * skeleton.cols + from.x;
+        cv::Point last = from;
+        while (!queue.empty()) {
+            last = queue.front();
+            queue.pop_front();
+            for (int k = 0; k < 8; ++k) {
+                cv::Point n(last.x + NEIGHBOUR_DX[k], last.y + NEIGHBOUR_DY[k]);
+                if (skeleton.at<uchar>(n.y, n.x) && parent.at<int>(n.y, n.x) < 0) {
+                    parent.at<int>(n.y, n.x) = last.y * skeleton.cols + last.x;
+                    queue.push_back(n);
+                }
+            }
+        }
+        return last;
+    };
+
+    cv::Mat parent;
+    cv::Point end_a = bfs(start, parent);
+    cv::Point end_b = bfs(end_a, parent);
+
+    std::vector<cv::Point> path;
+    cv::Point p = end_b;
+    while (true) {
+        path.push_back(p);
+        int index = parent.at<int>(p.y, p.x);
+        cv::Point prev(index % skeleton.cols, index / skeleton.cols);
+        if (prev == p) {
+            break;
+        }
+        p = prev;
+    }
+    return path;
+}
+
+} // namespace
+
+TrackCentreline::TrackCentreline()
+    : closed_(false), spacing_(5.0f), cell_size_(GRID_CELL_SIZE), grid_cols_(0), grid_rows_(0) {
+}
+
+void TrackCentreline::clear() {
+    waypoints_.clear();
+    clearance_.clear();
+    cell_offsets_.clear();
+    cell_indices_.clear();
+    closed_ = false;
+    grid_cols_ = grid_rows_ = 0;
+}
+
+bool TrackCentreline::extract(const cv::Mat& boundary_mask, const Position& seed, int seed_radius, float spacing) {
+    clear();
+    spacing_ = std::max(1.0f, spacing);
+
+    if (boundary_mask.empty() || seed.x < 0 || seed.x >= boundary_mask.cols ||
+        seed.y < 0 || seed.y >= boundary_mask.rows) {
+        return false;
+    }
+
+    // Drivable region (255) with the car cleared, padded by one pixel so neighbourhood
+    // lookups never leave the image
+    cv::Mat drivable;
+    cv::threshold(boundary_mask, drivable, 0, 255, cv::THRESH_BINARY_INV);
+    if (seed_radius > 0) {
+        cv::circle(drivable, cv::Point(seed.x, seed.y), seed_radius, cv::Scalar(255), -1);
+    }
+    cv::morphologyEx(drivable, drivable, cv::MORPH_OPEN,
+                     cv::getStructuringElement(cv::MORPH_ELLIPSE, cv::Size(5, 5)));
+
+    cv::Mat labels;
+    cv::connectedComponents(drivable, labels, 8, CV_32S);
+    int track_label = labels.at<int>(seed.y, seed.x);
+    if (track_label == 0) {
+        return false;
+    }
+
+    cv::Mat region = cv::Mat::zeros(drivable.rows + 2, drivable.cols + 2, CV_8UC1);
+    for (int y = 0; y < labels.rows; ++y) {
+        const int* label_row = labels.ptr<int>(y);
+        uchar* region_row = region.ptr<uchar>(y + 1);
+        for (int x = 0; x < labels.cols; ++x) {
+            region_row[x + 1] = label_row[x] == track_label ? 1 : 0;
+        }
+    }
+
+    cv::Mat distance;
+    cv::distanceTransform(region, distance, cv::DIST_L2, cv::DIST_MASK_PRECISE, CV_32F);
+
+    cv::Mat skeleton = region.clone();
+    thin(skeleton);
+
+    // Loop tracks: keep only the cycle; open tracks: longest path through the skeleton
+    cv::Point padded_seed(seed.x + 1, seed.y + 1);
+    std::vector<cv::Point> path;
+    cv::Mat loops = pruneToLoops(skeleton);
+    cv::Point loop_start = nearestOn(loops, padded_seed);
+    if (loop_start.x >= 0) {
+        path = traceLoop(loops, loop_start, closed_);
+    } else {
+        cv::Point open_start = nearestOn(skeleton, padded_seed);
+        if (open_start.x < 0) {
+            return false;
+        }
+        path = traceOpen(skeleton, open_start);
+        closed_ = false;
+    }
+    if (path.size() < 2) {
+        closed_ = false;
+        return false;
+    }
+
+    // Resample to evenly spaced waypoints (back in frame coordinates)
+    std::vector<cv::Point2f> pixels(path.size());
+    for (size_t i = 0; i < path.size(); ++i) {
+        pixels[i] = cv::Point2f(static_cast<float>(path[i].x - 1), static_cast<float>(path[i].y - 1));
+    }
+    std::vector<cv::Point2f> resampled;
+    std::vector<float> no_values;
+    resample(pixels, std::vector<float>(), closed_, spacing_, resampled, no_values);
+
+    // Take the pixel staircase out of the skeleton
+    size_t n = resampled.size();
+    waypoints_.resize(n);
+    for (size_t i = 0; i < n; ++i) {
+        cv::Point2f sum(0.0f, 0.0f);
+        int count = 0;
+        for (int j = -SMOOTHING_RADIUS; j <= SMOOTHING_RADIUS; ++j) {
+            long k = static_cast<long>(i) + j;
+            if (closed_) {
+                k = (k % static_cast<long>(n) + static_cast<long>(n)) % static_cast<long>(n);
+            } else if (k < 0 || k >= static_cast<long>(n)) {
+                continue;
+            }
+            sum.x += resampled[k].x;
+            sum.y += resampled[k].y;
+            ++count;
+        }
+        waypoints_[i] = cv::Point2f(sum.x / count, sum.y / count);
+    }
+
+    clearance_.resize(n);
+    for (size_t i = 0; i < n; ++i) {
+        int x = std::max(0, std::min(distance.cols - 1, static_cast<int>(std::lround(waypoints_[i].x)) + 1));
+        int y = std::max(0, std::min(distance.rows - 1, static_cast<int>(std::lround(waypoints_[i].y)) + 1));
+        clearance_[i] = distance.at<float>(y, x);
+    }
+
+    buildIndex();
+    return isValid();
+}
+
+void TrackCentreline::setWaypoints(const std::vector<cv::Point2f>& waypoints, const std::vector<float>& clearance,
+                                   bool closed, float spacing) {
+    waypoints_ = waypoints;
+    clearance_ = clearance;
+    clearance_.resize(waypoints_.size(), 0.0f);
+    closed_ = closed;
+    if (spacing > 0.0f) {
+        spacing_ = spacing;
+    } else if (waypoints_.size() >= 2) {
+        spacing_ = std::hypot(waypoints_[1].x - waypoints_[0].x, waypoints_[1].y - waypoints_[0].y);
+    }
+    buildIndex();
+}
+
+void TrackCentreline::resample(const std::vector<cv::Point2f>& points, const std::vector<float>& values, bool closed,
+                               float spacing, std::vector<cv::Point2f>& out, std::vector<float>& out_values) {
+    out.clear();
+    out_values.clear();
+    if (points.empty() || spacing <= 0.0f) {
+        return;
+    }
+    size_t n = points.size();
+    bool with_values = values.size() == n;
+
+    out.push_back(points[0]);
+    if (with_values) {
+        out_values.push_back(values[0]);
+    }
+    float carried = 0.0f;  // Arc length since the last emitted point
+    size_t segments = closed ? n : n - 1;
+    for (size_t i = 0; i < segments; ++i) {
+        const cv::Point2f& a = points[i];
+        const cv::Point2f& b = points[(i + 1) % n];
+        float length = std::hypot(b.x - a.x, b.y - a.y);
+        float t = spacing - carried;
+        while (t <= length) {
+            float f = length > 0.0f ? t / length : 0.0f;
+            out.push_back(a + (b - a) * f);
+            if (with_values) {
+                out_values.push_back(values[i] + (values[(i + 1) % n] - values[i]) * f);
+            }
+            t += spacing;
+        }
+        carried = length - (t - spacing);
+    }
+
+    if (closed && out.size() > 1) {
+        const cv::Point2f& last = out.back();
+        if (std::hypot(last.x - out[0].x, last.y - out[0].y) < spacing / 2.0f) {
+            out.pop_back();
+            if (with_values) {
+                out_values.pop_back();
+            }
+        }
+    }
+}
+
+namespace {
+
+// On-disk layout (little-endian): header followed by `count` waypoints
+struct CentrelineHeader {
+    char magic[4];       // "RCCL"
+    uint16_t version;
+    uint16_t flags;      // bit 0: closed loop
+    uint32_t count;
+    float spacing;
+};
+
+struct CentrelineEntry {
+    float x;
+    float y;
+    float clearance;
+};
+
+static_assert(sizeof(CentrelineHeader) == 16, "Centreline header must stay 16 bytes");
+
+constexpr char CENTRELINE_MAGIC[4] = {'R', 'C', 'C', 'L'};
+constexpr uint16_t CENTRELINE_VERSION = 1;
+constexpr uint16_t FLAG_CLOSED = 1;
+
+} // namespace
+
+bool TrackCentreline::save(const std::string& path) const {
+    if (!isValid()) {
+        std::cerr << "Error: No centreline to save" << std::endl;
+        return false;
+    }
+
+    std::ofstream file(path, std::ios::binary);
+    if (!file.is_open()) {
+        std::cerr << "Error: Could not write centreline: " << path << std::endl;
+        return false;
+    }
+
+    CentrelineHeader header;
+    std::memcpy(header.magic, CENTRELINE_MAGIC, sizeof(header.magic));
+    header.version = CENTRELINE_VERSION;
+    header.flags = closed_ ? FLAG_CLOSED : 0;
+    header.count = static_cast<uint32_t>(waypoints_.size());
+    header.spacing = spacing_;
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+    std::vector<CentrelineEntry> entries(waypoints_.size());
+    for (size_t i = 0; i < entries.size(); ++i) {
+        entries[i] = {waypoints_[i].x, waypoints_[i].y, clearance_[i]};
+    }
+    file.write(reinterpret_cast<const char*>(entries.data()), entries.size() * sizeof(CentrelineEntry));
+    return file.good();
+}
+
+bool TrackCentreline::load(const std::string& path) {
+    clear();
+    MappedFile file;
+    if (!file.open(path)) {
+        std::cerr << "Error: Could not open centreline: " << path << std::endl;
+        return false;
+    }
+
+    CentrelineHeader header;
+    if (file.size() < sizeof(header) ||
+        std::memcmp(file.data(), CENTRELINE_MAGIC, sizeof(header.magic)) != 0) {
+        std::cerr << "Error: Not a centreline file: " << path << std::endl;
+        return false;
+    }
+    std::memcpy(&header, file.data(), sizeof(header));
+    if (header.version != CENTRELINE_VERSION || header.count < 2 ||
+        file.size() != sizeof(header) + header.count * sizeof(CentrelineEntry)) {
+        std::cerr << "Error: Unsupported or truncated centreline: " << path << std::endl;
+        return false;
+    }
+
+    std::vector<CentrelineEntry> entries(header.count);
+    std::memcpy(entries.data(), file.data() + sizeof(header), entries.size() * sizeof(CentrelineEntry));
+    waypoints_.resize(header.count);
+    clearance_.resize(header.count);
+    for (size_t i = 0; i < entries.size(); ++i) {
+        waypoints_[i] = cv::Point2f(entries[i].x, entries[i].y);
+        clearance_[i] = entries[i].clearance;
+    }
+    closed_ = (header.flags & FLAG_CLOSED) != 0;
+    spacing_ = header.spacing;
+    buildIndex();
+    return isValid();
+}
+
+void TrackCentreline::buildIndex() {
+    float max_x = 0.0f;
+    float max_y = 0.0f;
+    for (const auto& p : waypoints_) {
+        max_x = std::max(max_x, p.x);
+        max_y = std::max(max_y, p.y);
+    }
+    grid_cols_ = static_cast<int>(max_x) / cell_size_ + 1;
+    grid_rows_ = static_cast<int>(max_y) / cell_size_ + 1;
+
+    // Counting sort of waypoint indices by cell
+    cell_offsets_.assign(static_cast<size_t>(grid_cols_) * grid_rows_ + 1, 0);
+    auto cellOf = [this](const cv::Point2f& p) {
+        int cx = std::max(0, std::min(grid_cols_ - 1, static_cast<int>(p.x) / cell_size_));
+        int cy = std::max(0, std::min(grid_rows_ - 1, static_cast<int>(p.y) / cell_size_));
+        return cy * grid_cols_ + cx;
+    };
+    for (const auto& p : waypoints_) {
+        ++cell_offsets_[cellOf(p) + 1];
+    }
+    for (size_t c = 1; c < cell_offsets_.size(); ++c) {
+        cell_offsets_[c] += cell_offsets_[c - 1];
+    }
+    cell_indices_.resize(waypoints_.size());
+    std::vector<int> fill(cell_offsets_.begin(), cell_offsets_.end() - 1);
+    for (size_t i = 0; i < waypoints_.size(); ++i) {
+        cell_indices_[fill[cellOf(waypoints_[i])]++] = static_cast<int>(i);
+    }
+}
+
+int TrackCentreline::nearestWaypoint(const cv::Point2f& p) const {
+    if (waypoints_.empty()) {
+        return -1;
+    }
+
+    int cx = std::max(0, std::min(grid_cols_ - 1, static_cast<int>(std::max(0.0f, p.x)) / cell_size_));
+    int cy = std::max(0, std::min(grid_rows_ - 1, static_cast<int>(std::max(0.0f, p.y)) / cell_size_));
+
+    // Search rings of cells outward; stop once the ring is farther than the best match
+    int best = -1;
+    float best_dist = std::numeric_limits<float>::max();
+    int max_ring = std::max(grid_cols_, grid_rows_);
+    for (int ring = 0; ring <= max_ring; ++ring) {
+        if (best >= 0) {
+            float ring_dist = static_cast<float>((ring - 1) * cell_size_);
+            if (ring_dist * ring_dist > best_dist) {
+                break;
+            }
+        }
+        for (int gy = cy - ring; gy <= cy + ring; ++gy) {
+            if (gy < 0 || gy >= grid_rows_) {
+                continue;
+            }
+            for (int gx = cx - ring; gx <= cx + ring; ++gx) {
+                if (gx < 0 || gx >= grid_cols_ ||
+                    (std::abs(gx - cx) != ring && std::abs(gy - cy) != ring)) {
+                    continue;
+                }
+                int cell = gy * grid_cols_ + gx;
+                for (int k = cell_offsets_[cell]; k < cell_offsets_[cell + 1]; ++k) {
+                    const cv::Point2f& w = waypoints_[cell_indices_[k]];
+                    float d = (w.x - p.x) * (w.x - p.x) + (w.y - p.y) * (w.y - p.y);
+                    if (d < best_dist) {
+                        best_dist = d;
+                        best = cell_indices_[k];
+                    }
+                }
+            }
+        }
+    }
+    return best;
+}
+
+int TrackCentreline::advance(int index, int steps, int direction) const {
+    int n = static_cast<int>(waypoints_.size());
+    if (n == 0) {
+        return -1;
+    }
+    int target = index + steps * (direction < 0 ? -1 : 1);
+    if (closed_) {
+        return ((target % n) + n) % n;
+    }
+    return std::max(0, std::min(n - 1, target));
+}
+
+cv::Point2f TrackCentreline::tangent(int index) const {
+    int prev = advance(index, 1, -1);
+    int next = advance(index, 1, 1);
+    if (prev < 0 || prev == next) {
+        return cv::Point2f(1.0f, 0.0f);
+    }
+    cv::Point2f d = waypoints_[next] - waypoints_[prev];
+    float length = std::hypot(d.x, d.y);
+    return length > 0.0f ? cv::Point2f(d.x / length, d.y / length) : cv::Point2f(1.0f, 0.0f);
+}
+
+} // namespace rc_car
@@ -0,0 +1,261 @@
+/**
+ * @file fake_peripheral.cpp
+ * @brief Stand-in for the car: a minimal ATT server on a local socket that logs the command stream
+ */
+
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <cerrno>
+#include <cstring>
+#include <signal.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include "ble_transport.h"
+#include "command_encoder.h"
+#include "config_manager.h"
+
+using namespace rc_car;
+
+namespace {
+
+volatile sig_atomic_t stop_requested = 0;
+
+void signalHandler(int) {
+    stop_requested = 1;
+}
+
+struct Characteristic {
+    uint16_t declaration;
+    uint8_t properties;
+    uint16_t value;
+    att::Uuid uuid;
+    bool short_uuid;
+};
+
+void printUsage(const char* program_name) {
+    std::cout << "Usage: " << program_name << " [options]" << std::endl;
+    std::cout << "Serves the car's GATT characteristic on a local socket; point ble.device_mac at" << std::endl;
+    std::cout << "unix:<socket> and the control system connects to it instead of the radio." << std::endl;
+    std::cout << "Options:" << std::endl;
+    std::cout << "  -c, --config <file>       Configuration file path (default: config/config.json)" << std::endl;
+    std::cout << "  -s, --socket <path>       Socket to listen on (default: from ble.device_mac, else /tmp/rc_car_ble.sock)" << std::endl;
+    std::cout << "  -h, --help               Show this help message" << std::endl;
+}
+
+// Read By Type over characteristic declarations: entries of one UUID size that fit the default MTU
+size_t readByType(const std::vector<Characteristic>& table, const uint8_t* request, size_t size, uint8_t* response) {
+    uint16_t start = att::getLe16(request + 1);
+    uint16_t end = att::getLe16(request + 3);
+    bool declarations = size == 7 && att::getLe16(request + 5) == att::CHARACTERISTIC_UUID;
+
+    size_t length = 0;
+    size_t out = 2;
+    for (const auto& c : table) {
+        if (!declarations || c.declaration < start || c.declaration > end) {
+            continue;
+        }
+        size_t entry = c.short_uuid ? 7 : 21;
+        if (length == 0) {
+            length = entry;
+        }
+        if (entry != length || out + entry > att::DEFAULT_MTU) {
+            break;
+        }
+        att::putLe16(response + out, c.declaration);
+        response[out + 2] = c.properties;
+        att::putLe16(response + out + 3, c.value);
+        if (c.short_uuid) {
+            response[out + 5] = c.uuid[12];
+            response[out + 6] = c.uuid[13];
+        } else {
+            std::memcpy(response + out + 5, c.uuid.data(), c.uuid.size());
+        }
+        out += entry;
+    }
+    if (length == 0) {
+        response[0] = att::ERROR_RSP;
+        response[1] = att::READ_BY_TYPE_REQ;
+        att::putLe16(response + 2, start);
+        response[4] = att::ERR_ATTRIBUTE_NOT_FOUND;
+        return 5;
+    }
+    response[0] = att::READ_BY_TYPE_RSP;
+    response[1] = static_cast<uint8_t>(length);
+    return out;
+}
+
+void logCommand(const uint8_t* packet, size_t size, long commands, double rate) {
+    std::cout << std::fixed << std::setprecision(1) << rate << " cmd/s (" << commands << " total)";
+    if (size == CommandEncoder::PACKET_SIZE) {
+        const size_t id = CommandEncoder::IDENTIFIER_SIZE;
+        uint8_t sum = 0;
+        for (size_t i = 0; i + 1 < size; ++i) {
+            sum = static_cast<uint8_t>(sum + packet[i]);
+        }
+        uint8_t checksum = packet[size - 1];
+        std::cout << "  speed " << ((packet[id] << 8) | packet[id + 1])
+                  << "  steering " << ((packet[id + 4] << 8) | packet[id + 5])
+                  << "  light " << std::hex << std::setw(4) << std::setfill('0')
+                  << ((packet[id + 6] << 8) | packet[id + 7]) << std::dec << std::setfill(' ')
+                  << "  checksum " << (checksum == sum ? "ok" : (checksum == 0 ? "off" : "BAD"));
+    } else {
+        std::cout << "  unexpected " << size << "-byte write";
+    }
+    std::cout << std::endl;
+}
+
+void serve(int client, const std::vector<Characteristic>& table, uint16_t command_handle) {
+    uint8_t request[att::MAX_PDU];
+    uint8_t response[att::MAX_PDU];
+    long commands = 0;
+    long window_commands = 0;
+    auto window_start = std::chrono::steady_clock::now();
+    std::vector<uint8_t> last_packet;
+
+    while (!stop_requested) {
+        pollfd pfd = {client, POLLIN, 0};
+        if (poll(&pfd, 1, 200) < 0 && errno != EINTR) {
+            break;
+        }
+        if (pfd.revents & POLLIN) {
+            ssize_t received = recv(client, request, sizeof(request), 0);
+            if (received <= 0) {
+                break;  // Client went away
+            }
+            size_t response_size = 0;
+            switch (request[0]) {
+            case att::MTU_REQ:
+                response[0] = att::MTU_RSP;
+                att::putLe16(response + 1, static_cast<uint16_t>(att::DEFAULT_MTU));
+                response_size = 3;
+                break;
+            case att::READ_BY_TYPE_REQ:
+                response_size = received >= 7 ? readByType(table, request, static_cast<size_t>(received), response) : 0;
+                break;
+            case att::WRITE_CMD:
+                if (received >= 3 && att::getLe16(request + 1) == command_handle) {
+                    ++commands;
+                    ++window_commands;
+                    last_packet.assign(request + 3, request + received);
+                }
+                break;
+            default:
+                // Commands (bit 6) never get a reply; unsupported requests get an error
+                if (!(request[0] & 0x40)) {
+                    response[0] = att::ERROR_RSP;
+                    response[1] = request[0];
+                    att::putLe16(response + 2, 0);
+                    response[4] = att::ERR_REQUEST_NOT_SUPPORTED;
+                    response_size = 5;
+                }
+                break;
+            }
+            if (response_size > 0 && send(client, response, response_size, MSG_NOSIGNAL) < 0) {
+                break;
+            }
+        }
+
+        // Once a second: command rate and the latest packet
+        auto now = std::chrono::steady_clock::now();
+        double elapsed = std::chrono::duration<double>(now - window_start).count();
+        if (elapsed >= 1.0) {
+            if (!last_packet.empty()) {
+                logCommand(last_packet.data(), last_packet.size(), commands, window_commands / elapsed);
+            }
+            window_commands = 0;
+            window_start = now;
+        }
+    }
+    std::cout << "Client disconnected after " << commands << " commands" << std::endl;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    std::string config_file = "config/config.json";
+    std::string socket_path;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "-h" || arg == "--help") {
+            printUsage(argv[0]);
+            return 0;
+        } else if ((arg == "-c" || arg == "--config") && i + 1 < argc) {
+            config_file = argv[++i];
+        } else if ((arg == "-s" || arg == "--socket") && i + 1 < argc) {
+            socket_path = argv[++i];
+        } else {
+            std::cerr << "Unknown or incomplete option: " << arg << std::endl;
+            printUsage(argv[0]);
+            return 1;
+        }
+    }
+
+    ConfigManager config(config_file);
+    if (socket_path.empty()) {
+        std::string address = config.getString("ble.device_mac", "");
+        socket_path = address.compare(0, 5, "unix:") == 0 ? address.substr(5) : "/tmp/rc_car_ble.sock";
+    }
+    att::Uuid command_uuid;
+    std::string uuid_text = config.getString("ble.characteristic_uuid", "6e400002-b5a3-f393-e0a9-e50e24dcca9e");
+    if (!att::parseUuid(uuid_text, command_uuid)) {
+        std::cerr << "Error: Invalid ble.characteristic_uuid: " << uuid_text << std::endl;
+        return 1;
+    }
+
+    // A small GATT table: device name, a notify characteristic, then the command characteristic,
+    // so discovery has to page through declarations of both UUID sizes
+    att::Uuid notify_uuid = command_uuid;
+    notify_uuid[12] = static_cast<uint8_t>(notify_uuid[12] + 1);
+    const uint16_t command_handle = 0x0010;
+    std::vector<Characteristic> table = {
+        {0x0002, 0x02, 0x0003, att::shortUuid(0x2a00), true},
+        {0x0004, 0x02, 0x0005, att::shortUuid(0x2a01), true},
+        {0x000c, 0x10, 0x000d, notify_uuid, false},
+        {0x000f, 0x0c, command_handle, command_uuid, false},
+    };
+
+    sockaddr_un addr;
+    std::memset(&addr, 0, sizeof(addr));
+    if (socket_path.size() >= sizeof(addr.sun_path)) {
+        std::cerr << "Error: Socket path too long: " << socket_path << std::endl;
+        return 1;
+    }
+    addr.sun_family = AF_UNIX;
+    std::memcpy(addr.sun_path, socket_path.c_str(), socket_path.size());
+
+    int server = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+    unlink(socket_path.c_str());
+    if (server < 0 || bind(server, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0 || listen(server, 1) < 0) {
+        std::cerr << "Error: Could not listen on " << socket_path << ": " << std::strerror(errno) << std::endl;
+        return 1;
+    }
+
+    signal(SIGINT, signalHandler);
+    signal(SIGTERM, signalHandler);
+    std::cout << "Fake peripheral on unix:" << socket_path << ", command characteristic " << uuid_text
+              << " at handle 0x" << std::hex << command_handle << std::dec << std::endl;
+
+    while (!stop_requested) {
+        pollfd pfd = {server, POLLIN, 0};
+        if (poll(&pfd, 1, 200) <= 0) {
+            continue;
+        }
+        int client = accept(server, nullptr, nullptr);
+        if (client < 0) {
+            continue;
+        }
+        std::cout << "Client connected" << std::endl;
+        serve(client, table, command_handle);
+        close(client);
+    }
+
+    close(server);
+    unlink(socket_path.c_str());
+    return 0;
+}
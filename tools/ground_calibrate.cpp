@@ -0,0 +1,243 @@
+/**
+ * @file ground_calibrate.cpp
+ * @brief Offline camera calibration: lens model + ground homography baked into bird's-eye remap tables
+ */
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <cstdlib>
+#include <cmath>
+#include <algorithm>
+#include <opencv2/opencv.hpp>
+#include "ground_projection.h"
+#include "config_manager.h"
+
+using namespace rc_car;
+
+namespace {
+
+constexpr int MAX_GRID = 4096;  // Bird's-eye pixels per axis around the board
+constexpr int COVERAGE_CELLS = 4;  // Per axis: board corners should reach most of a 4x4 split of the frame
+constexpr int MIN_COVERED_CELLS = 12;
+constexpr int PROBE_STEPS = 32;  // Points per frame edge when finding the ground the camera sees
+
+void printUsage(const char* program_name) {
+    std::cout << "Usage: " << program_name << " [options] <ground_image> [view_image...]" << std::endl;
+    std::cout << "  <ground_image> shows the chessboard lying flat on the track, taken from the mounted camera;" << std::endl;
+    std::cout << "  extra views of the board near the frame edges and corners fit the lens model there." << std::endl;
+    std::cout << "Options:" << std::endl;
+    std::cout << "  -c, --config <file>       Configuration file path (default: config/config.json)" << std::endl;
+    std::cout << "  --board <cols> <rows>     Inner corners of the chessboard (default: 9 6)" << std::endl;
+    std::cout << "  --square <mm>             Chessboard square size (default: 25)" << std::endl;
+    std::cout << "  --mm-per-px <mm>          Bird's-eye resolution (default: 2)" << std::endl;
+    std::cout << "  --max-range <mm>          Ground kept around the board; the far field is cut off (default: 3000)" << std::endl;
+    std::cout << "  -o, --output <file>       Table to write (default: boundary.ground_map)" << std::endl;
+    std::cout << "  -h, --help               Show this help message" << std::endl;
+}
+
+bool findBoard(const cv::Mat& image, cv::Size board, std::vector<cv::Point2f>& corners) {
+    cv::Mat gray;
+    cv::cvtColor(image, gray, cv::COLOR_BGR2GRAY);
+    if (!cv::findChessboardCorners(gray, board, corners)) {
+        return false;
+    }
+    cv::cornerSubPix(gray, corners, cv::Size(11, 11), cv::Size(-1, -1),
+                     cv::TermCriteria(cv::TermCriteria::EPS + cv::TermCriteria::COUNT, 30, 0.01));
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    std::string config_file = "config/config.json";
+    std::string output;
+    std::vector<std::string> images;
+    cv::Size board(9, 6);
+    double square = 25.0;
+    double mm_per_px = 2.0;
+    double max_range = 3000.0;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "-h" || arg == "--help") {
+            printUsage(argv[0]);
+            return 0;
+        } else if ((arg == "-c" || arg == "--config") && i + 1 < argc) {
+            config_file = argv[++i];
+        } else if ((arg == "-o" || arg == "--output") && i + 1 < argc) {
+            output = argv[++i];
+        } else if (arg == "--board" && i + 2 < argc) {
+            board.width = std::atoi(argv[++i]);
+            board.height = std::atoi(argv[++i]);
+        } else if (arg == "--square" && i + 1 < argc) {
+            square = std::atof(argv[++i]);
+        } else if (arg == "--mm-per-px" && i + 1 < argc) {
+            mm_per_px = std::atof(argv[++i]);
+        } else if (arg == "--max-range" && i + 1 < argc) {
+            max_range = std::atof(argv[++i]);
+        } else if (arg[0] != '-') {
+            images.push_back(arg);
+        } else {
+            std::cerr << "Unknown or incomplete option: " << arg << std::endl;
+            printUsage(argv[0]);
+            return 1;
+        }
+    }
+    if (images.empty() || board.width < 2 || board.height < 2 || square <= 0.0 || mm_per_px <= 0.0 ||
+        max_range <= 0.0) {
+        printUsage(argv[0]);
+        return 1;
+    }
+    if (output.empty()) {
+        ConfigManager config(config_file);
+        output = config.getString("boundary.ground_map", "");
+        if (output.empty()) {
+            std::cerr << "Error: No output file (-o) and boundary.ground_map is not set" << std::endl;
+            return 1;
+        }
+    }
+
+    // Board corners on the ground plane, in bird's-eye pixels
+    std::vector<cv::Point3f> object;
+    std::vector<cv::Point2f> ground_board;
+    for (int r = 0; r < board.height; ++r) {
+        for (int c = 0; c < board.width; ++c) {
+            object.emplace_back(static_cast<float>(c * square), static_cast<float>(r * square), 0.0f);
+            ground_board.emplace_back(static_cast<float>(c * square / mm_per_px), static_cast<float>(r * square / mm_per_px));
+        }
+    }
+
+    // Lens model from every view that shows the board (the first one must: it is the ground view)
+    std::vector<std::vector<cv::Point3f>> object_points;
+    std::vector<std::vector<cv::Point2f>> image_points;
+    cv::Size frame_size;
+    for (size_t i = 0; i < images.size(); ++i) {
+        cv::Mat image = cv::imread(images[i]);
+        if (image.empty()) {
+            std::cerr << "Error: Could not read image: " << images[i] << std::endl;
+            return 1;
+        }
+        if (i == 0) {
+            frame_size = image.size();
+        } else if (image.size() != frame_size) {
+            std::cerr << "Warning: Skipping " << images[i] << " (different resolution)" << std::endl;
+            continue;
+        }
+        std::vector<cv::Point2f> corners;
+        if (!findBoard(image, board, corners)) {
+            if (i == 0) {
+                std::cerr << "Error: Chessboard not found in the ground image: " << images[i] << std::endl;
+                return 1;
+            }
+            std::cerr << "Warning: Chessboard not found in " << images[i] << std::endl;
+            continue;
+        }
+        object_points.push_back(object);
+        image_points.push_back(corners);
+    }
+
+    // The lens model is fitted where the corners are and only extrapolated elsewhere
+    std::vector<bool> covered(COVERAGE_CELLS * COVERAGE_CELLS, false);
+    for (const auto& corners : image_points) {
+        for (const auto& p : corners) {
+            int cx = std::min(COVERAGE_CELLS - 1, std::max(0, static_cast<int>(p.x * COVERAGE_CELLS / frame_size.width)));
+            int cy = std::min(COVERAGE_CELLS - 1, std::max(0, static_cast<int>(p.y * COVERAGE_CELLS / frame_size.height)));
+            covered[cy * COVERAGE_CELLS + cx] = true;
+        }
+    }
+    int covered_cells = static_cast<int>(std::count(covered.begin(), covered.end(), true));
+    if (covered_cells < MIN_COVERED_CELLS) {
+        std::cerr << "Warning: Board corners reach only " << covered_cells << " of " << covered.size()
+                  << " parts of the frame; add views with the board near the edges and corners" << std::endl;
+    }
+
+    cv::Mat camera_matrix;
+    cv::Mat distortion;
+    std::vector<cv::Mat> rvecs;
+    std::vector<cv::Mat> tvecs;
+    double rms = cv::calibrateCamera(object_points, image_points, frame_size, camera_matrix, distortion, rvecs, tvecs);
+    std::cout << "Lens model from " << image_points.size() << " view(s), RMS reprojection error " << rms << " px" << std::endl;
+
+    // Ground homography from the undistorted board corners of the ground image
+    std::vector<cv::Point2f> undistorted;
+    cv::undistortPoints(image_points[0], undistorted, camera_matrix, distortion, cv::Mat(), camera_matrix);
+    cv::Mat board_homography = cv::findHomography(undistorted, ground_board);
+    if (board_homography.empty()) {
+        std::cerr << "Error: Could not fit the ground homography" << std::endl;
+        return 1;
+    }
+
+    GroundCalibration calib;
+    for (int k = 0; k < 9; ++k) {
+        calib.camera_matrix[k] = camera_matrix.at<double>(k / 3, k % 3);
+        calib.homography[k] = board_homography.at<double>(k / 3, k % 3);
+    }
+    for (int k = 0; k < 5; ++k) {
+        calib.distortion[k] = k < static_cast<int>(distortion.total()) ? distortion.at<double>(k) : 0.0;
+    }
+    calib.frame_width = frame_size.width;
+    calib.frame_height = frame_size.height;
+    calib.units_per_pixel = mm_per_px;
+
+    // Grid: the ground the camera sees within max_range of the board. Frame points on the far
+    // side of the horizon map through the homography with the opposite sign of w, landing
+    // mirrored behind the camera, so they are skipped; points just below it run off towards
+    // infinity and are cut off at the range.
+    std::vector<cv::Point2f> probes;
+    for (int k = 0; k <= PROBE_STEPS; ++k) {
+        float fx = frame_size.width * static_cast<float>(k) / PROBE_STEPS;
+        float fy = frame_size.height * static_cast<float>(k) / PROBE_STEPS;
+        probes.emplace_back(fx, 0.0f);
+        probes.emplace_back(fx, static_cast<float>(frame_size.height));
+        probes.emplace_back(0.0f, fy);
+        probes.emplace_back(static_cast<float>(frame_size.width), fy);
+    }
+    std::vector<cv::Point2f> probes_undistorted;
+    cv::undistortPoints(probes, probes_undistorted, camera_matrix, distortion, cv::Mat(), camera_matrix);
+
+    const double* h = calib.homography;
+    double board_w = 0.0;
+    for (const auto& p : undistorted) {
+        board_w += h[6] * p.x + h[7] * p.y + h[8];
+    }
+    cv::Point2f centre = (ground_board.front() + ground_board.back()) * 0.5f;
+    float reach = static_cast<float>(std::min<double>(MAX_GRID / 2, max_range / mm_per_px));
+    float min_x = centre.x - reach, max_x = centre.x + reach;
+    float min_y = centre.y - reach, max_y = centre.y + reach;
+    float lo_x = centre.x, hi_x = centre.x, lo_y = centre.y, hi_y = centre.y;
+    for (const auto& p : ground_board) {
+        lo_x = std::min(lo_x, p.x);
+        hi_x = std::max(hi_x, p.x);
+        lo_y = std::min(lo_y, p.y);
+        hi_y = std::max(hi_y, p.y);
+    }
+    for (const auto& p : probes_undistorted) {
+        double w = h[6] * p.x + h[7] * p.y + h[8];
+        if (w * board_w <= 0.0) {
+            continue;
+        }
+        float gx = static_cast<float>((h[0] * p.x + h[1] * p.y + h[2]) / w);
+        float gy = static_cast<float>((h[3] * p.x + h[4] * p.y + h[5]) / w);
+        lo_x = std::min(lo_x, std::max(min_x, gx));
+        hi_x = std::max(hi_x, std::min(max_x, gx));
+        lo_y = std::min(lo_y, std::max(min_y, gy));
+        hi_y = std::max(hi_y, std::min(max_y, gy));
+    }
+
+    // Shift the grid so it starts at (0, 0)
+    for (int k = 0; k < 3; ++k) {
+        calib.homography[k] -= lo_x * calib.homography[6 + k];
+        calib.homography[3 + k] -= lo_y * calib.homography[6 + k];
+    }
+    calib.width = static_cast<int>(std::ceil(hi_x - lo_x));
+    calib.height = static_cast<int>(std::ceil(hi_y - lo_y));
+
+    GroundProjection projection;
+    if (!projection.build(calib) || !projection.save(output)) {
+        return 1;
+    }
+    std::cout << "Ground projection written to " << output << ": " << calib.width << "x" << calib.height
+              << " at " << mm_per_px << " mm/px" << std::endl;
+    return 0;
+}
@@ -0,0 +1,129 @@
+/**
+ * @file track_preprocess.cpp
+ * @brief Offline track preprocessing: racing line / speed profile and ray policy tables from a track image
+ */
+
+#include <iostream>
+#include <string>
+#include <sstream>
+#include <cstdlib>
+#include <opencv2/opencv.hpp>
+#include "boundary_detection.h"
+#include "config_manager.h"
+
+using namespace rc_car;
+
+void printUsage(const char* program_name) {
+    std::cout << "Usage: " << program_name << " [options] <track_image>" << std::endl;
+    std::cout << "Options:" << std::endl;
+    std::cout << "  -c, --config <file>       Configuration file path (default: config/config.json)" << std::endl;
+    std::cout << "  --racing-line <file>      Write the racing line / speed profile table (needs --seed)" << std::endl;
+    std::cout << "  --seed <x> <y>            A pixel on the track (e.g. the car's start position)" << std::endl;
+    std::cout << "  --policy <file>           Write the (x, y, heading) ray policy table" << std::endl;
+    std::cout << "  -h, --help               Show this help message" << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+    std::string config_file = "config/config.json";
+    std::string track_image;
+    std::string racing_line_file;
+    std::string policy_file;
+    Position seed(-1, -1);
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "-h" || arg == "--help") {
+            printUsage(argv[0]);
+            return 0;
+        } else if ((arg == "-c" || arg == "--config") && i + 1 < argc) {
+            config_file = argv[++i];
+        } else if (arg == "--racing-line" && i + 1 < argc) {
+            racing_line_file = argv[++i];
+        } else if (arg == "--policy" && i + 1 < argc) {
+            policy_file = argv[++i];
+        } else if (arg == "--seed" && i + 2 < argc) {
+            seed.x = std::atoi(argv[++i]);
+            seed.y = std::atoi(argv[++i]);
+        } else if (arg[0] != '-' && track_image.empty()) {
+            track_image = arg;
+        } else {
+            std::cerr << "Unknown or incomplete option: " << arg << std::endl;
+            printUsage(argv[0]);
+            return 1;
+        }
+    }
+    if (track_image.empty() || (racing_line_file.empty() && policy_file.empty())) {
+        printUsage(argv[0]);
+        return 1;
+    }
+    if (!racing_line_file.empty() && seed.x < 0) {
+        std::cerr << "Error: --racing-line requires --seed <x> <y>" << std::endl;
+        return 1;
+    }
+
+    ConfigManager config(config_file);
+    BoundaryDetection guidance(config.getInt("boundary.black_threshold", 50),
+                               config.getInt("boundary.ray_max_length", 200),
+                               config.getInt("boundary.evasive_threshold", 80));
+    guidance.setCacheDirectory(config.getString("boundary.cache_dir", "cache"));
+    if (!guidance.loadTrackImage(track_image)) {
+        return 1;
+    }
+
+    if (!racing_line_file.empty()) {
+        guidance.setWaypointSpacing(static_cast<float>(config.getDouble("boundary.waypoint_spacing", 5.0)));
+
+        RacingLineParams params;
+        params.margin = static_cast<float>(config.getDouble("boundary.racing_margin", 10.0));
+        params.max_speed = static_cast<float>(config.getDouble("boundary.racing_max_speed", 40.0));
+        params.min_speed = static_cast<float>(config.getDouble("boundary.racing_min_speed", 10.0));
+        params.full_speed_radius = static_cast<float>(config.getDouble("boundary.racing_full_speed_radius", 300.0));
+        params.accel = static_cast<float>(config.getDouble("boundary.racing_accel", 2.0));
+        params.brake = static_cast<float>(config.getDouble("boundary.racing_brake", 4.0));
+        guidance.setRacingLineParams(params);
+
+        if (!guidance.extractCentreline(cv::Mat(), seed) || !guidance.buildRacingLine()) {
+            return 1;
+        }
+
+        const RacingLine& line = guidance.getRacingLine();
+        int slowest = 255;
+        int fastest = 0;
+        for (size_t i = 0; i < line.line().size(); ++i) {
+            slowest = std::min(slowest, line.speedAt(static_cast<int>(i)));
+            fastest = std::max(fastest, line.speedAt(static_cast<int>(i)));
+        }
+        std::cout << "Speed profile: " << slowest << " - " << fastest << std::endl;
+
+        if (!line.save(racing_line_file)) {
+            return 1;
+        }
+        std::cout << "Racing line written to " << racing_line_file << std::endl;
+    }
+
+    if (!policy_file.empty()) {
+        // Parse ray angles the same way as the orchestrator
+        std::string ray_angles_str = config.getString("boundary.ray_angles", "-60,0,60");
+        std::vector<double> ray_angles;
+        std::stringstream ss(ray_angles_str);
+        std::string angle_str;
+        while (std::getline(ss, angle_str, ',')) {
+            try {
+                ray_angles.push_back(std::stod(angle_str));
+            } catch (...) {
+                // Skip invalid angles
+            }
+        }
+        if (!ray_angles.empty()) {
+            guidance.setRayAngles(ray_angles);
+        }
+        guidance.setPolicyGrid(config.getInt("boundary.policy_cell_size", 8),
+                               config.getInt("boundary.policy_headings", 72));
+
+        if (!guidance.buildPolicyTable(cv::Mat(), Position()) || !guidance.getPolicyTable().save(policy_file)) {
+            return 1;
+        }
+        std::cout << "Policy table written to " << policy_file << std::endl;
+    }
+    return 0;
+}